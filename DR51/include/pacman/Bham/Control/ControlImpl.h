@@ -10,6 +10,8 @@
 
 #include <Golem/Ctrl/Controller.h>
 #include <pacman/Bham/Control/Control.h>
+#include <boost/thread/tss.hpp>
+#include <vector>
 
 /** PaCMan name space */
 namespace pacman {
@@ -49,6 +51,10 @@ namespace pacman {
 		virtual bool waitForTrajectoryEnd(double timewait = std::numeric_limits<float_t>::max());
 
 	protected:
+		/** Robot configuration compatibility */
+		template <golem::U32 CHAINS, golem::U32 JOINTS> static bool matchConfig(const ::golem::Controller::State::Info& info) {
+			return info.getChains().size() == CHAINS && info.getJoints().size() == JOINTS;
+		}
 		/** Assert robot configuration compatibility */
 		template <golem::U32 CHAINS, golem::U32 JOINTS> static void assertConfig(const ::golem::Controller::State::Info& info) {
 			if (info.getChains().size() != CHAINS)
@@ -61,6 +67,9 @@ namespace pacman {
 		/** Assert robot compatibility */
 		void assertRobotEddie() const;
 
+		/** Thread-local controller states, grown to at least size states */
+		::golem::Controller::State* getStates(std::uintptr_t size) const;
+
 		/** Conversion */
 		void convert(const ::golem::Controller::State& src, Robot::State& dst) const;
 		/** Conversion */
@@ -85,6 +94,13 @@ namespace pacman {
 		::golem::Context& context;
 		::golem::Controller& controller;
 		const ::golem::Controller::State::Info info;
+
+		/** Robot type matching the controller configuration, validated once at construction */
+		Robot::Type robotType;
+		/** The first joint of each chain */
+		std::vector< ::golem::Configspace::Index > chainJoints;
+		/** Controller states reused by each calling thread */
+		mutable boost::thread_specific_ptr< ::golem::Controller::State::Seq > states;
 	};
 };
 
@@ -10,6 +10,7 @@
 
 #include <pacman/PaCMan/Defs.h>
 #include <boost/shared_ptr.hpp>
+#include <functional>
 #include <string>
 
 /** PaCMan name space */
@@ -42,6 +43,40 @@ namespace pacman {
 			}
 		};
 
+		/** Grasp selection */
+		class Selection {
+		public:
+			/** Maximum number of trajectories */
+			std::uintptr_t size;
+			/** Maximum number of ranked candidates considered, including the ones below the elevation, 0 for all */
+			std::uintptr_t candidates;
+			/** Minimum grip elevation */
+			float_t elevation;
+			/** Drops grasps below the elevation and all but the candidates most likely ones by the classifier likelihood before they are ranked.
+			*	Ranking is then faster, but clusters are formed from the remaining grasps only, so their likelihoods change and the dropped grasps are not displayed.
+			*/
+			bool prefilter;
+
+			/** Default constructor sets the default configuration. */
+			inline Selection() {
+				setToDefault();
+			}
+			/** The default configuration. */
+			inline void setToDefault() {
+				size = 500;
+				candidates = 500;
+				elevation = float_t(0.1);
+				prefilter = false;
+			}
+			/** Checks if the description is valid. */
+			inline bool isValid() const {
+				return size > 0;
+			}
+		};
+
+		/** Trajectory handler, returns false to stop estimation */
+		typedef std::function<bool (const Trajectory&)> Handler;
+
 		/** Creates Birmingham grasp
 		 *	@param[in]	path			configuration file
 		*/
@@ -58,6 +93,14 @@ namespace pacman {
 		*/
 		virtual void estimate(const Point3D::Seq& points, Trajectory::Seq& trajectories) = 0;
 
+		/** Estimate at most selection.size best grasps above selection.elevation together with their approach trajectories
+		 *	@param[in]	points			query point cloud
+		 *	@param[in]	selection		grasp selection
+		 *	@param[out]	trajectories	weighted approach trajectories in order of decreasing likelihood
+		 *	@param[in]	handler			optional, called for each trajectory in order as soon as it and all better ones are ready, possibly from a worker thread
+		*/
+		virtual void estimate(const Point3D::Seq& points, const Selection& selection, Trajectory::Seq& trajectories, Handler handler = Handler()) = 0;
+
 		/** Process messages
 		*/
 		virtual void spin() = 0;
@@ -72,9 +115,11 @@ namespace pacman {
 	void save(const std::string& path, const Point3D::Seq& points);
 	/** Point cloud load */
 	void load(const std::string& path, Point3D::Seq& points);
-	/** Trajectory save */
+	/** Trajectory save, text format */
 	void save(const std::string& path, const RobotUIBK::Config::Seq& trajectory);
-	/** Trajectory load */
+	/** Trajectory save, versioned and checksummed binary format */
+	void saveBinary(const std::string& path, const RobotUIBK::Config::Seq& trajectory);
+	/** Trajectory load, binary or text format */
 	void load(const std::string& path, RobotUIBK::Config::Seq& trajectory);
 };
 
@@ -10,6 +10,8 @@
 
 #include <Grasp/ShapePlanner/ShapePlanner.h>
 #include <pacman/Bham/Grasp/Grasp.h>
+#include <functional>
+#include <vector>
 
 /** PaCMan name space */
 namespace pacman {
@@ -28,12 +30,57 @@ namespace pacman {
 		/** Estimate possible grasps together with their with approach trajectories from a given point cloud */
 		virtual void estimate(const Point3D::Seq& points, Trajectory::Seq& trajectories);
 
+		/** Estimate the best grasps together with their with approach trajectories from a given point cloud */
+		virtual void estimate(const Point3D::Seq& points, const Selection& selection, Trajectory::Seq& trajectories, Handler handler = Handler());
+
 		/** Estimate possible grasps together with their with approach trajectories from a given point cloud (version with curvatures) */
 		void estimate(const ::grasp::Cloud::PointSeq& points, Trajectory::Seq& trajectories);
 
+		/** Estimate the best grasps together with their with approach trajectories from a given point cloud (version with curvatures) */
+		void estimate(const ::grasp::Cloud::PointSeq& points, const Selection& selection, Trajectory::Seq& trajectories, Handler handler = Handler());
+
 		/** Process messages */
 		virtual void spin();
 
+		/** Normals and curvatures of the last converted point cloud, so that a repeated estimate only recomputes the neighbourhoods which have changed */
+		class FeatureCache {
+		public:
+			/** Feature computation over a whole point cloud */
+			typedef std::function<void (::grasp::Cloud::PointSeq&)> Compute;
+
+			/** Cache enabled */
+			bool enabled;
+			/** Distance within which points affect each other's features: the curvature search radius, plus the normal search radius if normals are recomputed.
+			*	Set from the point cloud description at creation, so that it follows the feature computation.
+			*/
+			golem::Real radius;
+			/** Fraction of points to recompute above which the whole point cloud is recomputed */
+			golem::Real maxDirty;
+
+			FeatureCache() : enabled(true), radius(golem::Real(0.03)), maxDirty(golem::Real(0.5)) {}
+
+			/** Computes features of points, reusing the previous results for points with unchanged neighbourhoods */
+			void compute(::grasp::Cloud::PointSeq& points, Compute func);
+			/** Forgets the previous point cloud */
+			void clear();
+
+		private:
+			/** Voxel key and point index, sorted by the key */
+			typedef std::vector<std::pair<std::uint64_t, std::uint32_t> > Index;
+
+			void build(const ::grasp::Cloud::PointSeq& points, Index& index) const;
+			template <typename _Func> void neighbours(const ::grasp::Cloud::PointSeq& points, const Index& index, const ::grasp::Cloud::Point& point, _Func func) const;
+
+			/** Previous input and output, in the same order */
+			::grasp::Cloud::PointSeq input, output;
+			/** Voxel index of the previous input */
+			Index index;
+			golem::CriticalSection cs;
+		};
+
+		/** Features of the last converted point cloud */
+		mutable FeatureCache featureCache;
+
 		/** Point cloud conversion */
 		void convert(const ::grasp::Cloud::PointSeq& src, Point3D::Seq& dst) const;
 		/** Point cloud conversion */
@@ -9,7 +9,15 @@
 #define _PACMAN_PACMAN_DEFS_H_
 
 #include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+#include <atomic>
 #include <vector>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
 
 /** PaCMan name space */
 namespace pacman {
@@ -128,6 +136,237 @@ namespace pacman {
 		}
 	};
 
+	/** Allocator of memory aligned to _Alignment bytes. */
+	template <typename _Type, std::uintptr_t _Alignment> class AlignedAllocator {
+	public:
+		typedef _Type value_type;
+		typedef _Type* pointer;
+		typedef const _Type* const_pointer;
+		typedef _Type& reference;
+		typedef const _Type& const_reference;
+		typedef std::size_t size_type;
+		typedef std::ptrdiff_t difference_type;
+
+		/** Allocator of other type */
+		template <typename _Other> struct rebind {
+			typedef AlignedAllocator<_Other, _Alignment> other;
+		};
+
+		inline AlignedAllocator() {}
+		template <typename _Other> inline AlignedAllocator(const AlignedAllocator<_Other, _Alignment>&) {}
+
+		inline pointer address(reference r) const {
+			return &r;
+		}
+		inline const_pointer address(const_reference r) const {
+			return &r;
+		}
+		inline size_type max_size() const {
+			return size_type(-1)/sizeof(_Type);
+		}
+		inline void construct(pointer p, const_reference val) {
+			new (p) _Type(val);
+		}
+		inline void destroy(pointer p) {
+			p->~_Type();
+		}
+
+		/** Allocates n elements, throws std::bad_alloc on failure. */
+		inline pointer allocate(size_type n, const void* = nullptr) {
+			if (n == 0)
+				return nullptr;
+			void* p;
+#ifdef _MSC_VER
+			p = _aligned_malloc(n*sizeof(_Type), _Alignment);
+#else
+			if (posix_memalign(&p, _Alignment, n*sizeof(_Type)) != 0)
+				p = nullptr;
+#endif
+			if (p == nullptr)
+				throw std::bad_alloc();
+			return static_cast<pointer>(p);
+		}
+		inline void deallocate(pointer p, size_type) {
+#ifdef _MSC_VER
+			_aligned_free(p);
+#else
+			std::free(p);
+#endif
+		}
+
+		inline bool operator == (const AlignedAllocator&) const {
+			return true;
+		}
+		inline bool operator != (const AlignedAllocator&) const {
+			return false;
+		}
+	};
+
+	/** 3D point cloud as a structure of single precision arrays, one array per point component.
+	*	Colour is packed into 32 bits as 0xAARRGGBB, the same way as in PCL and ROS point clouds.
+	*/
+	class Point3DCloud {
+	public:
+		/** Array alignment in bytes */
+		static const std::uintptr_t ALIGNMENT = 32;
+		/** Array of components */
+		typedef std::vector<float, AlignedAllocator<float, ALIGNMENT> > Array;
+		/** Array of packed colours */
+		typedef std::vector<std::uint32_t, AlignedAllocator<std::uint32_t, ALIGNMENT> > ColourArray;
+
+		/** Non-owning view of point components which are stride bytes apart, so it can refer to Point3DCloud
+		*	arrays as well as to array-of-structures point clouds. Missing components are null.
+		*/
+		class View {
+		public:
+			/** Position */
+			const float *x, *y, *z;
+			/** Normal */
+			const float *normalX, *normalY, *normalZ;
+			/** Curvature */
+			const float *curvature;
+			/** Packed colour */
+			const std::uint32_t *rgba;
+			/** Distance in bytes between consecutive elements */
+			std::uintptr_t stride;
+			/** Number of points */
+			std::uintptr_t size;
+
+			/** Default constructor sets the default values. */
+			inline View() {
+				setToDefault();
+			}
+			/** The default values. */
+			inline void setToDefault() {
+				x = y = z = nullptr;
+				normalX = normalY = normalZ = nullptr;
+				curvature = nullptr;
+				rgba = nullptr;
+				stride = sizeof(float);
+				size = 0;
+			}
+			/** Elements are adjacent, i.e. the view refers to arrays */
+			inline bool isContiguous() const {
+				return stride == sizeof(float);
+			}
+
+			/** Points [begin, end) in constant time */
+			inline View slice(std::uintptr_t begin, std::uintptr_t end) const {
+				View view(*this);
+				view.x = offset(x, begin); view.y = offset(y, begin); view.z = offset(z, begin);
+				view.normalX = offset(normalX, begin); view.normalY = offset(normalY, begin); view.normalZ = offset(normalZ, begin);
+				view.curvature = offset(curvature, begin);
+				view.rgba = offset(rgba, begin);
+				view.size = end - begin;
+				return view;
+			}
+			/** Point at index i */
+			inline Point3D get(std::uintptr_t i) const {
+				Point3D point;
+				point.position.x = (float_t)*offset(x, i); point.position.y = (float_t)*offset(y, i); point.position.z = (float_t)*offset(z, i);
+				if (normalX != nullptr) {
+					point.normal.x = (float_t)*offset(normalX, i); point.normal.y = (float_t)*offset(normalY, i); point.normal.z = (float_t)*offset(normalZ, i);
+				}
+				if (rgba != nullptr)
+					point.colour = unpack(*offset(rgba, i));
+				return point;
+			}
+
+		private:
+			template <typename _Type> inline _Type* offset(_Type* ptr, std::uintptr_t i) const {
+				return ptr != nullptr ? reinterpret_cast<_Type*>(reinterpret_cast<const char*>(ptr) + i*stride) : nullptr;
+			}
+		};
+
+		/** Position */
+		Array x, y, z;
+		/** Normal */
+		Array normalX, normalY, normalZ;
+		/** Curvature */
+		Array curvature;
+		/** Packed colour */
+		ColourArray rgba;
+
+		/** Number of points */
+		inline std::uintptr_t size() const {
+			return x.size();
+		}
+		/** No points */
+		inline bool empty() const {
+			return x.empty();
+		}
+		/** Resizes all arrays, new points have the default values of Point3D and zero curvature */
+		inline void resize(std::uintptr_t size) {
+			x.resize(size, 0.f); y.resize(size, 0.f); z.resize(size, 0.f);
+			normalX.resize(size, 0.f); normalY.resize(size, 0.f); normalZ.resize(size, 1.f); // Z direction
+			curvature.resize(size, 0.f);
+			rgba.resize(size, UINT32_MAX); // white colour
+		}
+		/** Reserves all arrays */
+		inline void reserve(std::uintptr_t size) {
+			x.reserve(size); y.reserve(size); z.reserve(size);
+			normalX.reserve(size); normalY.reserve(size); normalZ.reserve(size);
+			curvature.reserve(size);
+			rgba.reserve(size);
+		}
+		/** Removes all points */
+		inline void clear() {
+			resize(0);
+		}
+
+		/** View of all points, no data is copied */
+		inline View getView() const {
+			View view;
+			view.x = x.data(); view.y = y.data(); view.z = z.data();
+			view.normalX = normalX.data(); view.normalY = normalY.data(); view.normalZ = normalZ.data();
+			view.curvature = curvature.data();
+			view.rgba = rgba.data();
+			view.stride = sizeof(float);
+			view.size = size();
+			return view;
+		}
+
+		/** Point at index i */
+		inline Point3D get(std::uintptr_t i) const {
+			Point3D point;
+			point.position.x = (float_t)x[i]; point.position.y = (float_t)y[i]; point.position.z = (float_t)z[i];
+			point.normal.x = (float_t)normalX[i]; point.normal.y = (float_t)normalY[i]; point.normal.z = (float_t)normalZ[i];
+			point.colour = unpack(rgba[i]);
+			return point;
+		}
+		/** Sets point at index i, curvature is left unchanged */
+		inline void set(std::uintptr_t i, const Point3D& point) {
+			x[i] = (float)point.position.x; y[i] = (float)point.position.y; z[i] = (float)point.position.z;
+			normalX[i] = (float)point.normal.x; normalY[i] = (float)point.normal.y; normalZ[i] = (float)point.normal.z;
+			rgba[i] = pack(point.colour);
+		}
+
+		/** Colour packing */
+		static inline std::uint32_t pack(const RGBA& colour) {
+			return std::uint32_t(colour.a) << 24 | std::uint32_t(colour.r) << 16 | std::uint32_t(colour.g) << 8 | std::uint32_t(colour.b);
+		}
+		/** Colour unpacking */
+		static inline RGBA unpack(std::uint32_t rgba) {
+			RGBA colour;
+			colour.a = std::uint8_t(rgba >> 24); colour.r = std::uint8_t(rgba >> 16); colour.g = std::uint8_t(rgba >> 8); colour.b = std::uint8_t(rgba);
+			return colour;
+		}
+	};
+
+	/** Point cloud conversion */
+	inline void convert(const Point3D::Seq& src, Point3DCloud& dst) {
+		dst.resize(src.size());
+		for (std::uintptr_t i = 0; i < src.size(); ++i)
+			dst.set(i, src[i]);
+		std::fill(dst.curvature.begin(), dst.curvature.end(), 0.f);
+	}
+	/** Point cloud conversion */
+	inline void convert(const Point3DCloud& src, Point3D::Seq& dst) {
+		dst.resize(src.size());
+		for (std::uintptr_t i = 0; i < src.size(); ++i)
+			dst[i] = src.get(i);
+	}
+
 	/** Robot */
 	class Robot {
 	public:
@@ -491,6 +730,266 @@ namespace pacman {
 		typedef Data<Robot::Command, KukaLWR::CommandData, SchunkDexHand::CommandData, KITHead::CommandData> CommandData;
 		typedef pacman::Robot::TimeStamp<CommandData> Command;
 	};
+
+	/** Robot commands as a structure of single precision arrays: the robot type and the number of joints are stored once per buffer,
+	*	followed by a column of positions, velocities and accelerations per joint and a column of time stamps.
+	*	Joints follow the order of the command data members, e.g. arm then hand for RobotUIBK.
+	*/
+	template <typename _Command> class CommandBuffer {
+	public:
+		/** Command */
+		typedef _Command Command;
+		/** Array alignment in bytes */
+		static const std::uintptr_t ALIGNMENT = 32;
+		/** Array of joint values */
+		typedef std::vector<float, AlignedAllocator<float, ALIGNMENT> > Array;
+		/** Array of time stamps */
+		typedef std::vector<float_t, AlignedAllocator<float_t, ALIGNMENT> > TimeArray;
+
+		/** Robot type */
+		static const Robot::Type TYPE = _Command::TYPE;
+		/** Number of joints */
+		static const std::uintptr_t JOINTS = _Command::JOINTS;
+
+		/** Non-owning view of a range of commands, value i of joint j is at pos[j*stride + i] */
+		class View {
+		public:
+			/** Position, velocity and acceleration columns */
+			float *pos, *vel, *acc;
+			/** Time stamps */
+			float_t *t;
+			/** Distance in elements between the columns of consecutive joints */
+			std::uintptr_t stride;
+			/** Number of commands */
+			std::uintptr_t size;
+
+			/** Default constructor sets the default values. */
+			inline View() {
+				setToDefault();
+			}
+			/** The default values. */
+			inline void setToDefault() {
+				pos = vel = acc = nullptr;
+				t = nullptr;
+				stride = size = 0;
+			}
+
+			/** Commands [begin, end) in constant time */
+			inline View slice(std::uintptr_t begin, std::uintptr_t end) const {
+				View view(*this);
+				view.pos = pos + begin; view.vel = vel + begin; view.acc = acc + begin;
+				view.t = t + begin;
+				view.size = end - begin;
+				return view;
+			}
+
+			/** Position column of a joint */
+			inline float* getPos(std::uintptr_t joint) const {
+				return pos + joint*stride;
+			}
+			/** Velocity column of a joint */
+			inline float* getVel(std::uintptr_t joint) const {
+				return vel + joint*stride;
+			}
+			/** Acceleration column of a joint */
+			inline float* getAcc(std::uintptr_t joint) const {
+				return acc + joint*stride;
+			}
+
+			/** Copies the commands to a view of the same size */
+			inline void copyTo(const View& view) const {
+				for (std::uintptr_t j = 0; j < JOINTS; ++j) {
+					std::copy(getPos(j), getPos(j) + size, view.getPos(j));
+					std::copy(getVel(j), getVel(j) + size, view.getVel(j));
+					std::copy(getAcc(j), getAcc(j) + size, view.getAcc(j));
+				}
+				std::copy(t, t + size, view.t);
+			}
+
+			/** Writes command i */
+			inline void set(std::uintptr_t i, const _Command& command) const {
+				std::uintptr_t joint = 0;
+				put(i, joint, command);
+				t[i] = command.t;
+			}
+			/** Reads command i */
+			inline void get(std::uintptr_t i, _Command& command) const {
+				std::uintptr_t joint = 0;
+				take(i, joint, command);
+				command.t = t[i];
+			}
+
+		private:
+			template <typename _Config> inline void put(std::uintptr_t i, std::uintptr_t& joint, const Robot::CommandData<_Config>& data) const {
+				for (std::uintptr_t j = 0; j < _Config::JOINTS; ++j, ++joint) {
+					getPos(joint)[i] = (float)data.pos.c[j];
+					getVel(joint)[i] = (float)data.vel.c[j];
+					getAcc(joint)[i] = (float)data.acc.c[j];
+				}
+			}
+			template <typename _Config> inline void take(std::uintptr_t i, std::uintptr_t& joint, Robot::CommandData<_Config>& data) const {
+				for (std::uintptr_t j = 0; j < _Config::JOINTS; ++j, ++joint) {
+					data.pos.c[j] = (float_t)getPos(joint)[i];
+					data.vel.c[j] = (float_t)getVel(joint)[i];
+					data.acc.c[j] = (float_t)getAcc(joint)[i];
+				}
+			}
+			inline void put(std::uintptr_t i, std::uintptr_t& joint, const RobotUIBK::CommandData& data) const {
+				put(i, joint, data.arm);
+				put(i, joint, data.hand);
+			}
+			inline void take(std::uintptr_t i, std::uintptr_t& joint, RobotUIBK::CommandData& data) const {
+				take(i, joint, data.arm);
+				take(i, joint, data.hand);
+			}
+			inline void put(std::uintptr_t i, std::uintptr_t& joint, const RobotEddie::CommandData& data) const {
+				put(i, joint, data.armLeft);
+				put(i, joint, data.handLeft);
+				put(i, joint, data.armRight);
+				put(i, joint, data.handRight);
+				put(i, joint, data.head);
+			}
+			inline void take(std::uintptr_t i, std::uintptr_t& joint, RobotEddie::CommandData& data) const {
+				take(i, joint, data.armLeft);
+				take(i, joint, data.handLeft);
+				take(i, joint, data.armRight);
+				take(i, joint, data.handRight);
+				take(i, joint, data.head);
+			}
+		};
+
+		/** Creates a buffer for capacity commands. */
+		inline CommandBuffer(std::uintptr_t capacity = 0) : capacity(0), stride(0) {
+			reserve(capacity);
+		}
+
+		/** Robot type */
+		inline Robot::Type getType() const {
+			return TYPE;
+		}
+		/** Number of joints */
+		inline std::uintptr_t getJoints() const {
+			return JOINTS;
+		}
+		/** Number of commands */
+		inline std::uintptr_t getCapacity() const {
+			return capacity;
+		}
+
+		/** Reallocates the buffer, previous commands are lost. */
+		inline void reserve(std::uintptr_t capacity) {
+			this->capacity = capacity;
+			// every column starts aligned
+			const std::uintptr_t n = ALIGNMENT/sizeof(float);
+			stride = (capacity + n - 1)/n*n;
+			pos.assign(JOINTS*stride, 0.f);
+			vel.assign(JOINTS*stride, 0.f);
+			acc.assign(JOINTS*stride, 0.f);
+			t.assign(capacity, float_t(0.));
+		}
+
+		/** All commands */
+		inline View getView() {
+			View view;
+			view.pos = pos.data(); view.vel = vel.data(); view.acc = acc.data();
+			view.t = t.data();
+			view.stride = stride;
+			view.size = capacity;
+			return view;
+		}
+		/** Commands [begin, end) in constant time */
+		inline View getView(std::uintptr_t begin, std::uintptr_t end) {
+			return getView().slice(begin, end);
+		}
+
+	private:
+		std::uintptr_t capacity, stride;
+		Array pos, vel, acc;
+		TimeArray t;
+	};
+
+	/** Lock-free single producer, single consumer queue of robot commands in a CommandBuffer ring.
+	*	The producer calls push(), the consumer calls front() and pop(); neither blocks nor allocates.
+	*/
+	template <typename _Command> class CommandQueue {
+	public:
+		/** Buffer */
+		typedef CommandBuffer<_Command> Buffer;
+		/** View */
+		typedef typename Buffer::View View;
+
+		/** Creates a queue of capacity commands. */
+		inline CommandQueue(std::uintptr_t capacity) : buffer(capacity), head(0), tail(0) {}
+
+		/** Number of commands */
+		inline std::uintptr_t getCapacity() const {
+			return buffer.getCapacity();
+		}
+		/** Number of queued commands */
+		inline std::uintptr_t size() const {
+			return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+		}
+
+		/** Producer: queues a command, returns false if the queue is full. */
+		inline bool push(const _Command& command) {
+			const std::uintptr_t h = head.load(std::memory_order_relaxed);
+			if (h - tail.load(std::memory_order_acquire) >= buffer.getCapacity())
+				return false;
+			buffer.getView().set(h%buffer.getCapacity(), command);
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+		/** Producer: queues as many commands of the view as fit, returns their number. */
+		inline std::uintptr_t push(const View& commands) {
+			const std::uintptr_t h = head.load(std::memory_order_relaxed);
+			const std::uintptr_t n = std::min(commands.size, buffer.getCapacity() - (h - tail.load(std::memory_order_acquire)));
+			for (std::uintptr_t i = 0; i < n;) {
+				// up to the end of the ring
+				const std::uintptr_t begin = (h + i)%buffer.getCapacity(), size = std::min(n - i, buffer.getCapacity() - begin);
+				commands.slice(i, i + size).copyTo(buffer.getView(begin, begin + size));
+				i += size;
+			}
+			head.store(h + n, std::memory_order_release);
+			return n;
+		}
+
+		/** Consumer: the oldest queued commands which are contiguous in the ring, empty if there are none. */
+		inline View front() {
+			const std::uintptr_t t = tail.load(std::memory_order_relaxed);
+			const std::uintptr_t n = head.load(std::memory_order_acquire) - t;
+			const std::uintptr_t begin = t%std::max(buffer.getCapacity(), std::uintptr_t(1));
+			return buffer.getView(begin, begin + std::min(n, buffer.getCapacity() - begin));
+		}
+		/** Consumer: removes n commands returned by front(). */
+		inline void pop(std::uintptr_t n) {
+			tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+		}
+		/** Consumer: removes all queued commands, the producer may call it only while the consumer is excluded, e.g. by a lock. */
+		inline void clear() {
+			tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+		}
+		/** Consumer: dequeues a command, returns false if the queue is empty. */
+		inline bool pop(_Command& command) {
+			const View view = front();
+			if (view.size == 0)
+				return false;
+			view.get(0, command);
+			pop(1);
+			return true;
+		}
+
+	private:
+		CommandQueue(const CommandQueue&);
+		CommandQueue& operator = (const CommandQueue&);
+
+		Buffer buffer;
+		/** Number of commands pushed and popped, kept on separate cache lines */
+		char pad0[64];
+		std::atomic<std::uintptr_t> head;
+		char pad1[64 - sizeof(std::atomic<std::uintptr_t>)];
+		std::atomic<std::uintptr_t> tail;
+		char pad2[64 - sizeof(std::atomic<std::uintptr_t>)];
+	};
 };
 
 #endif // _PACMAN_PACMAN_DEFS_H_
\ No newline at end of file
@@ -99,6 +99,140 @@ namespace pacman {
 			dst.push_back(p);
 		}
 	}
+
+	/** pcl::PointXYZ point cloud conversion */
+	template <typename _PCLPointXYX> void convertPCLPointXYZ(const pcl::PointCloud<_PCLPointXYX>& src, Point3DCloud& dst) {
+		const _PCLPointXYX* p = src.points.data();
+		float *x = dst.x.data(), *y = dst.y.data(), *z = dst.z.data();
+		for (std::uintptr_t i = 0, size = src.size(); i < size; ++i) {
+			x[i] = p[i].x;
+			y[i] = p[i].y;
+			z[i] = p[i].z;
+		}
+	}
+	template <typename _PCLPointXYX> void convertPCLPointXYZ(const Point3DCloud& src, pcl::PointCloud<_PCLPointXYX>& dst) {
+		_PCLPointXYX* p = dst.points.data();
+		const float *x = src.x.data(), *y = src.y.data(), *z = src.z.data();
+		for (std::uintptr_t i = 0, size = src.size(); i < size; ++i) {
+			p[i].x = x[i];
+			p[i].y = y[i];
+			p[i].z = z[i];
+		}
+	}
+	template <typename _PCLPointXYX> void viewPCLPointXYZ(const pcl::PointCloud<_PCLPointXYX>& src, Point3DCloud::View& dst) {
+		const _PCLPointXYX* p = src.points.data();
+		dst.x = &p->x;
+		dst.y = &p->y;
+		dst.z = &p->z;
+		dst.stride = sizeof(_PCLPointXYX);
+		dst.size = src.size();
+	}
+
+	/** pcl::PointNormal point cloud conversion, together with curvature */
+	template <typename _PCLPointNormal> void convertPCLPointNormal(const pcl::PointCloud<_PCLPointNormal>& src, Point3DCloud& dst) {
+		const _PCLPointNormal* p = src.points.data();
+		float *normalX = dst.normalX.data(), *normalY = dst.normalY.data(), *normalZ = dst.normalZ.data(), *curvature = dst.curvature.data();
+		for (std::uintptr_t i = 0, size = src.size(); i < size; ++i) {
+			normalX[i] = p[i].normal_x;
+			normalY[i] = p[i].normal_y;
+			normalZ[i] = p[i].normal_z;
+			curvature[i] = p[i].curvature;
+		}
+	}
+	template <typename _PCLPointNormal> void convertPCLPointNormal(const Point3DCloud& src, pcl::PointCloud<_PCLPointNormal>& dst) {
+		_PCLPointNormal* p = dst.points.data();
+		const float *normalX = src.normalX.data(), *normalY = src.normalY.data(), *normalZ = src.normalZ.data(), *curvature = src.curvature.data();
+		for (std::uintptr_t i = 0, size = src.size(); i < size; ++i) {
+			p[i].normal_x = normalX[i];
+			p[i].normal_y = normalY[i];
+			p[i].normal_z = normalZ[i];
+			p[i].curvature = curvature[i];
+		}
+	}
+	template <typename _PCLPointNormal> void viewPCLPointNormal(const pcl::PointCloud<_PCLPointNormal>& src, Point3DCloud::View& dst) {
+		const _PCLPointNormal* p = src.points.data();
+		dst.normalX = &p->normal_x;
+		dst.normalY = &p->normal_y;
+		dst.normalZ = &p->normal_z;
+		dst.curvature = &p->curvature;
+	}
+
+	/** pcl::PointRGBA point cloud conversion, colours are packed the same way */
+	template <typename _PCLPointRGBA> void convertPCLPointRGBA(const pcl::PointCloud<_PCLPointRGBA>& src, Point3DCloud& dst) {
+		const _PCLPointRGBA* p = src.points.data();
+		std::uint32_t* rgba = dst.rgba.data();
+		for (std::uintptr_t i = 0, size = src.size(); i < size; ++i)
+			rgba[i] = p[i].rgba;
+	}
+	template <typename _PCLPointRGBA> void convertPCLPointRGBA(const Point3DCloud& src, pcl::PointCloud<_PCLPointRGBA>& dst) {
+		_PCLPointRGBA* p = dst.points.data();
+		const std::uint32_t* rgba = src.rgba.data();
+		for (std::uintptr_t i = 0, size = src.size(); i < size; ++i)
+			p[i].rgba = rgba[i];
+	}
+	template <typename _PCLPointRGBA> void viewPCLPointRGBA(const pcl::PointCloud<_PCLPointRGBA>& src, Point3DCloud::View& dst) {
+		dst.rgba = reinterpret_cast<const std::uint32_t*>(&src.points.data()->rgba);
+	}
+
+	/** pcl::PointXYZ point cloud conversion */
+	inline void convert(const pcl::PointCloud<pcl::PointXYZ>& src, Point3DCloud& dst) {
+		dst.clear();
+		dst.resize(src.size());
+		convertPCLPointXYZ(src, dst);
+	}
+	inline void convert(const Point3DCloud& src, pcl::PointCloud<pcl::PointXYZ>& dst) {
+		dst.resize(src.size());
+		convertPCLPointXYZ(src, dst);
+	}
+	/** pcl::PointXYZ point cloud view, no data is copied */
+	inline Point3DCloud::View getView(const pcl::PointCloud<pcl::PointXYZ>& src) {
+		Point3DCloud::View view;
+		viewPCLPointXYZ(src, view);
+		return view;
+	}
+
+	/** pcl::PointNormal point cloud conversion */
+	inline void convert(const pcl::PointCloud<pcl::PointNormal>& src, Point3DCloud& dst) {
+		dst.clear();
+		dst.resize(src.size());
+		convertPCLPointXYZ(src, dst);
+		convertPCLPointNormal(src, dst);
+	}
+	inline void convert(const Point3DCloud& src, pcl::PointCloud<pcl::PointNormal>& dst) {
+		dst.resize(src.size());
+		convertPCLPointXYZ(src, dst);
+		convertPCLPointNormal(src, dst);
+	}
+	/** pcl::PointNormal point cloud view, no data is copied */
+	inline Point3DCloud::View getView(const pcl::PointCloud<pcl::PointNormal>& src) {
+		Point3DCloud::View view;
+		viewPCLPointXYZ(src, view);
+		viewPCLPointNormal(src, view);
+		return view;
+	}
+
+	/** pcl::PointXYZRGBNormal point cloud conversion */
+	inline void convert(const pcl::PointCloud<pcl::PointXYZRGBNormal>& src, Point3DCloud& dst) {
+		dst.clear();
+		dst.resize(src.size());
+		convertPCLPointXYZ(src, dst);
+		convertPCLPointNormal(src, dst);
+		convertPCLPointRGBA(src, dst);
+	}
+	inline void convert(const Point3DCloud& src, pcl::PointCloud<pcl::PointXYZRGBNormal>& dst) {
+		dst.resize(src.size());
+		convertPCLPointXYZ(src, dst);
+		convertPCLPointNormal(src, dst);
+		convertPCLPointRGBA(src, dst);
+	}
+	/** pcl::PointXYZRGBNormal point cloud view, no data is copied */
+	inline Point3DCloud::View getView(const pcl::PointCloud<pcl::PointXYZRGBNormal>& src) {
+		Point3DCloud::View view;
+		viewPCLPointXYZ(src, view);
+		viewPCLPointNormal(src, view);
+		viewPCLPointRGBA(src, view);
+		return view;
+	}
 };
 
 #endif // _PACMAN_PACMAN_PCL_H_
\ No newline at end of file
@@ -13,6 +13,7 @@
 
 // all generated headers from services we have in pacman ros_pkgs
 #include <ros/ros.h>
+#include <sensor_msgs/JointState.h>
 #include "definitions/GraspPlanning.h"
 #include "definitions/KinectGrabberService.h"
 #include "definitions/ObjectCloudReader.h"
@@ -20,9 +21,104 @@
 #include "definitions/TrajectoryExecution.h"
 #include "definitions/TrajectoryPlanning.h"
 
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 /** PaCMan name space */
 namespace pacman {
 
+	// RobotEddie joints in the order of the pacman conversions, the names are defined in the urdf of the UIBK robot
+	const char* const EDDIE_JOINT_NAMES[RobotEddie::Config::JOINTS] = {
+		"left_arm_0_joint", "left_arm_1_joint", "left_arm_2_joint", "left_arm_3_joint", "left_arm_4_joint", "left_arm_5_joint", "left_arm_6_joint",
+		"right_arm_0_joint", "right_arm_1_joint", "right_arm_2_joint", "right_arm_3_joint", "right_arm_4_joint", "right_arm_5_joint", "right_arm_6_joint",
+		"left_sdh_knuckle_joint", "left_sdh_finger_12_joint", "left_sdh_finger_13_joint", "left_sdh_finger_22_joint", "left_sdh_finger_23_joint", "left_sdh_thumb_2_joint", "left_sdh_thumb_3_joint",
+		"right_sdh_knuckle_joint", "right_sdh_finger_12_joint", "right_sdh_finger_13_joint", "right_sdh_finger_22_joint", "right_sdh_finger_23_joint", "right_sdh_thumb_2_joint", "right_sdh_thumb_3_joint",
+		"head_neck_pitch_joint", "head_neck_yaw_joint", "head_neck_roll_joint", "head_head_tilt_joint", "head_eyes_tilt_joint", "head_left_eye_joint", "head_right_eye_joint",
+	};
+
+	// offsets of the limbs in EDDIE_JOINT_NAMES
+	enum {
+		EDDIE_ARM_LEFT = 0,
+		EDDIE_ARM_RIGHT = 7,
+		EDDIE_HAND_LEFT = 14,
+		EDDIE_HAND_RIGHT = 21,
+		EDDIE_HEAD = 28,
+		EDDIE_EYE_LEFT = 33,
+		EDDIE_EYE_RIGHT = 34,
+	};
+
+	// maps the joints of a sensor_msgs::JointState to the RobotEddie order by name
+	// the table is built once per message layout, i.e. the sequence of joint names, and rebuilt only when it changes
+	class JointStateMap
+	{
+	public:
+		JointStateMap() : valid(false) {}
+
+		// checks the layout of the message, rebuilds the table if it has changed and returns true in that case
+		// throws std::runtime_error if any of the RobotEddie joints is missing
+		bool update(const sensor_msgs::JointState &joint_states)
+		{
+			if (valid && joint_states.name == names)
+				return false;
+
+			std::vector<std::uint32_t> table(RobotEddie::Config::JOINTS);
+			for (size_t k = 0; k < RobotEddie::Config::JOINTS; k++)
+			{
+				std::vector<std::string>::const_iterator name = std::find(joint_states.name.begin(), joint_states.name.end(), EDDIE_JOINT_NAMES[k]);
+				if (name == joint_states.name.end())
+					throw std::runtime_error(std::string("pacman::JointStateMap::update(): joint state has no ") + EDDIE_JOINT_NAMES[k]);
+				table[k] = std::uint32_t(name - joint_states.name.begin());
+			}
+
+			if (valid)
+				ROS_WARN("pacman::JointStateMap: the joint state layout has changed, %zu joints", joint_states.name.size());
+
+			names = joint_states.name;
+			index.swap(table);
+			valid = true;
+			return true;
+		}
+
+		// copies the positions of the RobotEddie joints in the RobotEddie order
+		// throws std::runtime_error if the position field does not have a value for every joint name
+		void gatherPositions(const std::vector<double> &position, double *values) const
+		{
+			if (position.size() != names.size())
+				throw std::runtime_error("pacman::JointStateMap::gatherPositions(): joint state has an empty or incomplete position field");
+
+			copy(position, values);
+		}
+
+		// copies the values of the RobotEddie joints from an optional field of the message (velocity or effort) in the RobotEddie order
+		// an empty or incomplete field gives zeros
+		void gather(const std::vector<double> &field, double *values) const
+		{
+			if (field.size() != names.size())
+			{
+				std::fill(values, values + RobotEddie::Config::JOINTS, 0.0);
+				return;
+			}
+
+			copy(field, values);
+		}
+
+	private:
+		void copy(const std::vector<double> &field, double *values) const
+		{
+			const double *src = field.data();
+			const std::uint32_t *idx = index.data();
+			for (size_t k = 0; k < RobotEddie::Config::JOINTS; k++)
+				values[k] = src[idx[k]];
+		}
+
+		std::vector<std::string> names;
+		std::vector<std::uint32_t> index;
+		bool valid;
+	};
+
 	/** from ros trajectory to pacman interface */
 	void convert(const definitions::Trajectory &trajectory, RobotUIBK::Command::Seq &commands, pacman::float_t start_time)
 	{
@@ -179,125 +275,128 @@ namespace pacman {
 		return;
 	}
 
-	void convertLimb(const moveit_msgs::RobotTrajectory &moveitTraj, definitions::Trajectory &trajectory, sensor_msgs::JointState start_state, std::string arm)
+	// the limbs which do not move stay in the start state, its joints are found by name, the map is updated if the layout of the message has changed
+	void convertLimb(const moveit_msgs::RobotTrajectory &moveitTraj, definitions::Trajectory &trajectory, const sensor_msgs::JointState &start_state, const std::string &arm, JointStateMap &map)
 	{
-        // get the points from robot trajectory
+		// get the points from robot trajectory
 		const std::vector<trajectory_msgs::JointTrajectoryPoint> &points = moveitTraj.joint_trajectory.points;
-	    double epsilon = 0.009;
+		const double epsilon = 0.009;
 
-		// pick each point from the trajectory and create a RobotEddie object
-		for (size_t i = 0; i < points.size(); ++i) 
-		{
-			definitions::RobotEddie robot_point;
-            bool found = false;
-			for( size_t j = 0;( (j < points[i].positions.size()) && ( i > 0 ) ); j++ )
-			{
-               if( fabs(points[i].positions[j] - points[i-1].positions[j] ) > epsilon  )
-               {
-               	  found = true;
-               	  //std::cout << "joint " << j << " are different " << points[i].positions[j]  << " : " << points[i-1].positions[j] << std::endl;
-               	  break;
-               }
-			}
-            if( ( !found ) && ( i > 0 ) )
-            	continue;			
+		map.update(start_state);
+		double start_position[RobotEddie::Config::JOINTS], start_velocity[RobotEddie::Config::JOINTS];
+		map.gatherPositions(start_state.position, start_position);
+		map.gather(start_state.velocity, start_velocity);
 
-			// for testing with arms, later, it should be fixed to obtain eddie's trajectories
-			if(arm.compare(std::string("right")) == 0)
-			{
-				// arm mapping
-				for(int j = 0; j < KukaLWR::Config::JOINTS; j++)
-				{
-					robot_point.armRight.joints.push_back(points[i].positions.at(j));
-					robot_point.armRight.velocity.push_back(points[i].velocities.at(j));
-					robot_point.armRight.acceleration.push_back(points[i].accelerations.at(j));
-
-					robot_point.armLeft.joints.push_back(start_state.position[j]);
-					robot_point.armLeft.velocity.push_back(start_state.velocity[j]);
-					robot_point.armLeft.acceleration.push_back(0.0);
-				}
-
-				// hand mapping
-				// this order depends on the moveit trajectory planner
-				robot_point.handRight.joints.resize(SchunkDexHand::Config::JOINTS);
-				robot_point.handRight.velocity.resize(SchunkDexHand::Config::JOINTS);
-				robot_point.handRight.acceleration.resize(SchunkDexHand::Config::JOINTS);
-
-				for(int h = 0; h < SchunkDexHand::Config::JOINTS; h++)
-				{
-					robot_point.handRight.joints[h] = points[i].positions[7+h];
-					robot_point.handRight.velocity[h] = points[i].velocities[7+h];
-					robot_point.handRight.acceleration[h] = points[i].accelerations[7+h];
-
-					robot_point.handLeft.joints.push_back(start_state.position[h+14]);
-					robot_point.handLeft.velocity.push_back(start_state.velocity[h+14]);
-					robot_point.handLeft.acceleration.push_back(0.0);
-				}
-			}
+		const bool right = arm == "right";
+		const bool left = arm == "left";
 
-			if(arm.compare(std::string("left")) == 0)
-			{
-				for(int j = 0; j < KukaLWR::Config::JOINTS; j++)
-				{
-					robot_point.armLeft.joints.push_back(points[i].positions.at(j));
-					robot_point.armLeft.velocity.push_back(points[i].velocities.at(j));
-					robot_point.armLeft.acceleration.push_back(points[i].accelerations.at(j));
-
-					robot_point.armRight.joints.push_back(start_state.position[j+7]);
-					robot_point.armRight.velocity.push_back(start_state.velocity[j+7]);
-					robot_point.armRight.acceleration.push_back(0.0);
-				}
-
-				// hand mapping
-				// this order depends on the moveit trajectory planner
-				robot_point.handLeft.joints.resize(SchunkDexHand::Config::JOINTS);
-				robot_point.handLeft.velocity.resize(SchunkDexHand::Config::JOINTS);
-				robot_point.handLeft.acceleration.resize(SchunkDexHand::Config::JOINTS);
-
-				for(int h = 0; h < SchunkDexHand::Config::JOINTS; h++)
-				{
-					robot_point.handLeft.joints[h] = points[i].positions[7+h];
-					robot_point.handLeft.velocity[h] = points[i].velocities[7+h];
-					robot_point.handLeft.acceleration[h] = points[i].accelerations[7+h];
-
-					robot_point.handRight.joints.push_back(start_state.position[h+21]);
-					robot_point.handRight.velocity.push_back(start_state.velocity[h+21]);
-					robot_point.handRight.acceleration.push_back(0.0);
-				}
-			}
+		// the planned arm followed by its hand, this order depends on the moveit trajectory planner
+		const size_t limb_joints = KukaLWR::Config::JOINTS + SchunkDexHand::Config::JOINTS;
 
-			for(int k = 0; k < KITHead::Config::JOINTS_NECK; k++)
+		// pack the positions into a matrix, one row per point
+		const size_t dims = points.empty() ? 0 : points[0].positions.size();
+		std::vector<double> packed(points.size()*dims);
+		for (size_t i = 0; i < points.size(); ++i)
+		{
+			if (points[i].positions.size() != dims)
+				throw std::runtime_error("pacman::convertLimb(): trajectory points have different numbers of joints");
+			if ((right || left) && (dims < limb_joints || points[i].velocities.size() < limb_joints || points[i].accelerations.size() < limb_joints))
+				throw std::runtime_error("pacman::convertLimb(): trajectory points have too few joints");
+			std::copy(points[i].positions.begin(), points[i].positions.end(), packed.begin() + i*dims);
+		}
+
+		// a point is kept if any joint moved more than epsilon since the previous point, in a single pass over the matrix
+		std::vector<size_t> kept;
+		kept.reserve(points.size());
+		for (size_t i = 0; i < points.size(); ++i)
+		{
+			if (i > 0)
 			{
-				robot_point.head.joints.push_back(start_state.position[k+28]);
-				robot_point.head.velocity.push_back(start_state.velocity[k+28]);
-				robot_point.head.acceleration.push_back(0.0);
+				const double *curr = packed.data() + i*dims, *prev = curr - dims;
+				double delta = 0.0;
+				for (size_t j = 0; j < dims; j++)
+					delta = std::max(delta, std::fabs(curr[j] - prev[j]));
+				if (delta <= epsilon)
+					continue;
 			}
+			kept.push_back(i);
+		}
 
-			robot_point.head.jointsLEye = start_state.position[33];
-			robot_point.head.velocityLEye = start_state.velocity[33];
-			robot_point.head.accelerationLEye = 0.0;
-
-			robot_point.head.jointsREye = start_state.position[34];
-			robot_point.head.velocityREye = start_state.velocity[34];
-			robot_point.head.accelerationREye = 0.0;
+		auto assign = [] (std::vector<float> &dst, const double *src, size_t size) { dst.assign(src, src + size); };
+		auto zeros = [] (std::vector<float> &dst, size_t size) { dst.assign(size, 0.f); };
 
-			trajectory.eddie_path.push_back(robot_point);
+		// the joints in the start state are the same in every point, for testing with arms, later, it should be fixed to obtain eddie's trajectories
+		definitions::RobotEddie still;
+		if (right)
+		{
+			assign(still.armLeft.joints, start_position + EDDIE_ARM_LEFT, KukaLWR::Config::JOINTS);
+			assign(still.armLeft.velocity, start_velocity + EDDIE_ARM_LEFT, KukaLWR::Config::JOINTS);
+			zeros(still.armLeft.acceleration, KukaLWR::Config::JOINTS);
+			assign(still.handLeft.joints, start_position + EDDIE_HAND_LEFT, SchunkDexHand::Config::JOINTS);
+			assign(still.handLeft.velocity, start_velocity + EDDIE_HAND_LEFT, SchunkDexHand::Config::JOINTS);
+			zeros(still.handLeft.acceleration, SchunkDexHand::Config::JOINTS);
+		}
+		if (left)
+		{
+			assign(still.armRight.joints, start_position + EDDIE_ARM_RIGHT, KukaLWR::Config::JOINTS);
+			assign(still.armRight.velocity, start_velocity + EDDIE_ARM_RIGHT, KukaLWR::Config::JOINTS);
+			zeros(still.armRight.acceleration, KukaLWR::Config::JOINTS);
+			assign(still.handRight.joints, start_position + EDDIE_HAND_RIGHT, SchunkDexHand::Config::JOINTS);
+			assign(still.handRight.velocity, start_velocity + EDDIE_HAND_RIGHT, SchunkDexHand::Config::JOINTS);
+			zeros(still.handRight.acceleration, SchunkDexHand::Config::JOINTS);
+		}
+		assign(still.head.joints, start_position + EDDIE_HEAD, KITHead::Config::JOINTS_NECK);
+		assign(still.head.velocity, start_velocity + EDDIE_HEAD, KITHead::Config::JOINTS_NECK);
+		zeros(still.head.acceleration, KITHead::Config::JOINTS_NECK);
+		still.head.jointsLEye = start_position[EDDIE_EYE_LEFT];
+		still.head.velocityLEye = start_velocity[EDDIE_EYE_LEFT];
+		still.head.accelerationLEye = 0.0;
+		still.head.jointsREye = start_position[EDDIE_EYE_RIGHT];
+		still.head.velocityREye = start_velocity[EDDIE_EYE_RIGHT];
+		still.head.accelerationREye = 0.0;
+
+		// size the output once, every point starts as a copy of the start state
+		const size_t offset = trajectory.eddie_path.size();
+		trajectory.eddie_path.resize(offset + kept.size(), still);
+		trajectory.time_from_previous.resize(offset + kept.size());
+
+		for (size_t k = 0; k < kept.size(); ++k)
+		{
+			const size_t i = kept[k];
+			const trajectory_msgs::JointTrajectoryPoint &point = points[i];
+			definitions::RobotEddie &robot_point = trajectory.eddie_path[offset + k];
 
-			if (i == 0)
+			// the planned arm and hand, copied as contiguous blocks
+			if (right || left)
 			{
-				trajectory.time_from_previous.push_back( ros::Duration().fromSec(0.) );	
-			}
-			else
-			{
-				// the RobotTrajectory gives time_from_start, we prefer from previous for easier transformation to pacman commands
-				ros::Duration dt( points[i].time_from_start - points[i-1].time_from_start );
-				trajectory.time_from_previous.push_back( dt );
+				definitions::KukaLWR &planned_arm = right ? robot_point.armRight : robot_point.armLeft;
+				definitions::SDHand &planned_hand = right ? robot_point.handRight : robot_point.handLeft;
+				assign(planned_arm.joints, point.positions.data(), KukaLWR::Config::JOINTS);
+				assign(planned_arm.velocity, point.velocities.data(), KukaLWR::Config::JOINTS);
+				assign(planned_arm.acceleration, point.accelerations.data(), KukaLWR::Config::JOINTS);
+				assign(planned_hand.joints, point.positions.data() + KukaLWR::Config::JOINTS, SchunkDexHand::Config::JOINTS);
+				assign(planned_hand.velocity, point.velocities.data() + KukaLWR::Config::JOINTS, SchunkDexHand::Config::JOINTS);
+				assign(planned_hand.acceleration, point.accelerations.data() + KukaLWR::Config::JOINTS, SchunkDexHand::Config::JOINTS);
 			}
+
+			// the RobotTrajectory gives time_from_start, we prefer from previous for easier transformation to pacman commands
+			trajectory.time_from_previous[offset + k] = i == 0 ? ros::Duration().fromSec(0.) : ros::Duration(point.time_from_start - points[i-1].time_from_start);
 		}
 	}
 
-	void convertJointStateToEddie(const sensor_msgs::JointState &state, definitions::RobotEddie &eddie)
-	{	
+	void convertLimb(const moveit_msgs::RobotTrajectory &moveitTraj, definitions::Trajectory &trajectory, sensor_msgs::JointState start_state, std::string arm)
+	{
+		JointStateMap map;
+		convertLimb(moveitTraj, trajectory, start_state, arm, map);
+	}
+
+	// the joints are found by name, the map is updated if the layout of the message has changed
+	void convertJointStateToEddie(const sensor_msgs::JointState &state, definitions::RobotEddie &eddie, JointStateMap &map)
+	{
+		map.update(state);
+		double position[RobotEddie::Config::JOINTS], velocity[RobotEddie::Config::JOINTS];
+		map.gatherPositions(state.position, position);
+		map.gather(state.velocity, velocity);
 
 		// arms mapping
 		eddie.armRight.joints.resize(KukaLWR::Config::JOINTS);
@@ -308,12 +407,12 @@ namespace pacman {
 		eddie.armLeft.acceleration.resize(KukaLWR::Config::JOINTS);
 		for(int j = 0; j < KukaLWR::Config::JOINTS; j++)
 		{
-			eddie.armRight.joints.at(j) = state.position[j+7];
-			eddie.armRight.velocity.at(j) = state.velocity[j+7];
+			eddie.armRight.joints.at(j) = position[EDDIE_ARM_RIGHT + j];
+			eddie.armRight.velocity.at(j) = velocity[EDDIE_ARM_RIGHT + j];
 			eddie.armRight.acceleration.at(j) = 0.0;
 
-			eddie.armLeft.joints.at(j) = state.position[j];
-			eddie.armLeft.velocity.at(j) = state.velocity[j];
+			eddie.armLeft.joints.at(j) = position[EDDIE_ARM_LEFT + j];
+			eddie.armLeft.velocity.at(j) = velocity[EDDIE_ARM_LEFT + j];
 			eddie.armLeft.acceleration.at(j) = 0.0;
 		}
 
@@ -326,12 +425,12 @@ namespace pacman {
 		eddie.handLeft.acceleration.resize(SchunkDexHand::Config::JOINTS);
 		for(int h = 0; h < SchunkDexHand::Config::JOINTS; h++)
 		{
-			eddie.handLeft.joints.at(h) = state.position[h+14];
-			eddie.handLeft.velocity.at(h) = state.velocity[h+14];
+			eddie.handLeft.joints.at(h) = position[EDDIE_HAND_LEFT + h];
+			eddie.handLeft.velocity.at(h) = velocity[EDDIE_HAND_LEFT + h];
 			eddie.handLeft.acceleration.at(h) = 0.0;
 
-			eddie.handRight.joints.at(h) = state.position[h+21];
-			eddie.handRight.velocity.at(h) = state.velocity[h+21];
+			eddie.handRight.joints.at(h) = position[EDDIE_HAND_RIGHT + h];
+			eddie.handRight.velocity.at(h) = velocity[EDDIE_HAND_RIGHT + h];
 			eddie.handRight.acceleration.at(h) = 0.0;
 		}
 
@@ -341,22 +440,30 @@ namespace pacman {
 		eddie.head.acceleration.resize(KITHead::Config::JOINTS);
 		for(int k = 0; k < KITHead::Config::JOINTS_NECK; k++)
 		{
-			eddie.head.joints.at(k) = state.position[k+28];
-			eddie.head.velocity.at(k) = state.velocity[k+28];
+			eddie.head.joints.at(k) = position[EDDIE_HEAD + k];
+			eddie.head.velocity.at(k) = velocity[EDDIE_HEAD + k];
 			eddie.head.acceleration.at(k) = 0.0;
 		}
 
-		eddie.head.jointsLEye = state.position[33];
-		eddie.head.velocityLEye = state.velocity[33];
+		eddie.head.jointsLEye = position[EDDIE_EYE_LEFT];
+		eddie.head.velocityLEye = velocity[EDDIE_EYE_LEFT];
 		eddie.head.accelerationLEye = 0.0;
 
-		eddie.head.jointsREye = state.position[34];
-		eddie.head.velocityREye = state.velocity[34];
+		eddie.head.jointsREye = position[EDDIE_EYE_RIGHT];
+		eddie.head.velocityREye = velocity[EDDIE_EYE_RIGHT];
 		eddie.head.accelerationREye = 0.0;
 	}
 
+	// callers converting a stream of messages should keep a JointStateMap and use the version above
+	void convertJointStateToEddie(const sensor_msgs::JointState &state, definitions::RobotEddie &eddie)
+	{
+		JointStateMap map;
+		convertJointStateToEddie(state, eddie, map);
+	}
+
 	// this mapping uses names defined in the urdf of the UIBK robot, so be careful if you change them
-	void mapStates(const RobotEddie::State &state, sensor_msgs::JointState &joint_states, ros::Time stamp) 
+	// the names and sizes only need to be set once for a message that is reused
+	void mapStateNames(sensor_msgs::JointState &joint_states) 
 	{
 
 		// initialize the joint state topic
@@ -364,42 +471,15 @@ namespace pacman {
 		joint_states.position.resize(RobotEddie::Config::JOINTS);
 		joint_states.velocity.resize(RobotEddie::Config::JOINTS);
 		joint_states.effort.resize(RobotEddie::Config::JOINTS);
-		joint_states.name[0] = "left_arm_0_joint";
-		joint_states.name[1] = "left_arm_1_joint";
-		joint_states.name[2] = "left_arm_2_joint";
-		joint_states.name[3] = "left_arm_3_joint";
-		joint_states.name[4] = "left_arm_4_joint";
-		joint_states.name[5] = "left_arm_5_joint";
-		joint_states.name[6] = "left_arm_6_joint";
-		joint_states.name[7] = "right_arm_0_joint";
-		joint_states.name[8] = "right_arm_1_joint";
-		joint_states.name[9] = "right_arm_2_joint";
-		joint_states.name[10] = "right_arm_3_joint";
-		joint_states.name[11] = "right_arm_4_joint"; 
-		joint_states.name[12] = "right_arm_5_joint";
-		joint_states.name[13] = "right_arm_6_joint"; 
-		joint_states.name[14] = "left_sdh_knuckle_joint";
-		joint_states.name[15] = "left_sdh_finger_12_joint";
-		joint_states.name[16] = "left_sdh_finger_13_joint";
-		joint_states.name[17] = "left_sdh_finger_22_joint";
-		joint_states.name[18] = "left_sdh_finger_23_joint";
-		joint_states.name[19] = "left_sdh_thumb_2_joint";
-		joint_states.name[20] = "left_sdh_thumb_3_joint";
-		joint_states.name[21] = "right_sdh_knuckle_joint";
-		joint_states.name[22] = "right_sdh_finger_12_joint";
-		joint_states.name[23] = "right_sdh_finger_13_joint";
-		joint_states.name[24] = "right_sdh_finger_22_joint";
-		joint_states.name[25] = "right_sdh_finger_23_joint";
-		joint_states.name[26] = "right_sdh_thumb_2_joint";
-		joint_states.name[27] = "right_sdh_thumb_3_joint";
-		joint_states.name[28] = "head_neck_pitch_joint";
-		joint_states.name[29] = "head_neck_yaw_joint";
-		joint_states.name[30] = "head_neck_roll_joint";
-		joint_states.name[31] = "head_head_tilt_joint";
-		joint_states.name[32] = "head_eyes_tilt_joint";
-		joint_states.name[33] = "head_left_eye_joint";
-		joint_states.name[34] = "head_right_eye_joint";
+		for (size_t k = 0; k < RobotEddie::Config::JOINTS; k++)
+			joint_states.name[k] = EDDIE_JOINT_NAMES[k];
 
+		return;
+	}
+
+	// only the stamp and the positions, the message must have been initialised with mapStateNames
+	void mapStatePositions(const RobotEddie::State &state, sensor_msgs::JointState &joint_states, ros::Time stamp) 
+	{
 		joint_states.header.stamp = stamp;
 
 		// the joint mapping needs to be hardcoded to match Golem.xml and Ros.urdf structures
@@ -438,92 +518,160 @@ namespace pacman {
 	}
 
 	// this mapping uses names defined in the urdf of the UIBK robot, so be careful if you change them
-	void mapStates(const sensor_msgs::JointState &joint_states, RobotEddie::State &state) 
+	void mapStates(const RobotEddie::State &state, sensor_msgs::JointState &joint_states, ros::Time stamp) 
+	{
+		mapStateNames(joint_states);
+		mapStatePositions(state, joint_states, stamp);
+	}
+
+	// the joints are found by name, the map is updated if the layout of the message has changed
+	void mapStates(const sensor_msgs::JointState &joint_states, RobotEddie::State &state, JointStateMap &map) 
 	{
+		map.update(joint_states);
+		double position[RobotEddie::Config::JOINTS];
+		map.gatherPositions(joint_states.position, position);
 
-		// the joint mapping needs to be hardcoded to match Golem.xml and Ros.urdf structures
-		// note that, the names are set in the class constructor for the order convention
-		// and let the party begin... first the arm:
 		for (int j = 0; j < KukaLWR::Config::JOINTS; j++)
 		{
-			state.armLeft.pos.c[j] = joint_states.position[j];
-			state.armRight.pos.c[j] = joint_states.position[j+7];
+			state.armLeft.pos.c[j] = position[EDDIE_ARM_LEFT + j];
+			state.armRight.pos.c[j] = position[EDDIE_ARM_RIGHT + j];
 		}
 
-		// and continue with the hands:
-		state.handLeft.pos.rotation = joint_states.position[14];
-		state.handLeft.pos.left[0] = joint_states.position[15];
-		state.handLeft.pos.left[1] = joint_states.position[16];
-		state.handLeft.pos.right[0] = joint_states.position[17];
-		state.handLeft.pos.right[1] = joint_states.position[18];
-		state.handLeft.pos.middle[0] = joint_states.position[19];
-		state.handLeft.pos.middle[1] = joint_states.position[20];
-
-		state.handRight.pos.rotation = joint_states.position[21];
-		state.handRight.pos.left[0] = joint_states.position[22];
-		state.handRight.pos.left[1] = joint_states.position[23];
-		state.handRight.pos.right[0] = joint_states.position[24];
-		state.handRight.pos.right[1] = joint_states.position[25];
-		state.handRight.pos.middle[0] = joint_states.position[26]; 
-		state.handRight.pos.middle[1] = joint_states.position[27];
-
-		state.head.pos.neck[0] = joint_states.position[28];
-		state.head.pos.neck[1] = joint_states.position[29];
-		state.head.pos.neck[2] = joint_states.position[30];
-		state.head.pos.neck[3] = joint_states.position[31];
-		state.head.pos.neck[4] = joint_states.position[32];
-		state.head.pos.eyeLeft = joint_states.position[33];
-		state.head.pos.eyeRight = joint_states.position[34];
+		// the hands in the urdf order
+		state.handLeft.pos.rotation = position[EDDIE_HAND_LEFT + 0];
+		state.handLeft.pos.left[0] = position[EDDIE_HAND_LEFT + 1];
+		state.handLeft.pos.left[1] = position[EDDIE_HAND_LEFT + 2];
+		state.handLeft.pos.right[0] = position[EDDIE_HAND_LEFT + 3];
+		state.handLeft.pos.right[1] = position[EDDIE_HAND_LEFT + 4];
+		state.handLeft.pos.middle[0] = position[EDDIE_HAND_LEFT + 5];
+		state.handLeft.pos.middle[1] = position[EDDIE_HAND_LEFT + 6];
+
+		state.handRight.pos.rotation = position[EDDIE_HAND_RIGHT + 0];
+		state.handRight.pos.left[0] = position[EDDIE_HAND_RIGHT + 1];
+		state.handRight.pos.left[1] = position[EDDIE_HAND_RIGHT + 2];
+		state.handRight.pos.right[0] = position[EDDIE_HAND_RIGHT + 3];
+		state.handRight.pos.right[1] = position[EDDIE_HAND_RIGHT + 4];
+		state.handRight.pos.middle[0] = position[EDDIE_HAND_RIGHT + 5];
+		state.handRight.pos.middle[1] = position[EDDIE_HAND_RIGHT + 6];
+
+		for (int k = 0; k < KITHead::Config::JOINTS_NECK; k++)
+			state.head.pos.neck[k] = position[EDDIE_HEAD + k];
+		state.head.pos.eyeLeft = position[EDDIE_EYE_LEFT];
+		state.head.pos.eyeRight = position[EDDIE_EYE_RIGHT];
 
 		return;
 	}
 
-    void interpolateHandJoints(const definitions::SDHand &goalState, const sensor_msgs::JointState &startState, moveit_msgs::RobotTrajectory &baseTrajectory, const std::string &arm,bool is_cart = true)
+	// this mapping uses names defined in the urdf of the UIBK robot, so be careful if you change them
+	// callers converting a stream of messages should keep a JointStateMap and use the version above
+	void mapStates(const sensor_msgs::JointState &joint_states, RobotEddie::State &state) 
 	{
-		int NWayPoints = baseTrajectory.joint_trajectory.points.size();
-		int right_hand_index = 21;
-		int left_hand_index = 14;
-		int hand_index = 0;
+		JointStateMap map;
+		mapStates(joint_states, state, map);
+	}
 
-		//std::cout << "startState NWayPoints" << NWayPoints << std::endl << startState << std::endl;
+	// time profiles of the hand interpolation
+	enum HandProfile
+	{
+		// constant velocity
+		HAND_PROFILE_LINEAR,
+		// cubic polynomial, zero velocity at both ends
+		HAND_PROFILE_CUBIC,
+		// minimum jerk quintic polynomial, zero velocity and acceleration at both ends
+		HAND_PROFILE_MIN_JERK,
+	};
+
+	// the fraction s of the motion done at the normalised time x in [0, 1], together with its first two derivatives
+	inline void handProfile(HandProfile profile, double x, double &s, double &ds, double &dds)
+	{
+		const double x2 = x*x, x3 = x2*x;
+		switch (profile)
+		{
+		case HAND_PROFILE_CUBIC:
+			s = 3.0*x2 - 2.0*x3;
+			ds = 6.0*x - 6.0*x2;
+			dds = 6.0 - 12.0*x;
+			break;
+		case HAND_PROFILE_MIN_JERK:
+			s = 10.0*x3 - 15.0*x3*x + 6.0*x3*x2;
+			ds = 30.0*x2 - 60.0*x3 + 30.0*x3*x;
+			dds = 60.0*x - 180.0*x2 + 120.0*x3;
+			break;
+		default:
+			s = x;
+			ds = 1.0;
+			dds = 0.0;
+		}
+	}
 
-		//std::cout << goalState << std::endl;
+	// appends the hand joints to every point of the arm trajectory, going from the start state to the goal over the duration of the trajectory
+	// if is_cart is false the hand is kept at the goal for the whole trajectory
+	// the default profile ends at rest, as the arm does
+	// a trajectory without timing is interpolated by the point index and gets zero hand velocities and accelerations
+	// the joints of the start state are found by name, the map is updated if the layout of the message has changed
+	void interpolateHandJoints(const definitions::SDHand &goalState, const sensor_msgs::JointState &startState, moveit_msgs::RobotTrajectory &baseTrajectory, const std::string &arm, JointStateMap &map, bool is_cart = true, HandProfile profile = HAND_PROFILE_MIN_JERK)
+	{
+		std::vector<trajectory_msgs::JointTrajectoryPoint> &points = baseTrajectory.joint_trajectory.points;
+		const size_t NWayPoints = points.size();
+		const size_t HandJoints = SchunkDexHand::Config::JOINTS;
+
+		if (NWayPoints == 0)
+			return;
+		if (goalState.joints.size() < HandJoints)
+			throw std::runtime_error("pacman::interpolateHandJoints(): the goal has too few hand joints");
+		if (arm != "right" && arm != "left")
+			throw std::runtime_error("pacman::interpolateHandJoints(): unknown arm " + arm);
+
+		// the hand in the start state
+		map.update(startState);
+		double start_position[RobotEddie::Config::JOINTS];
+		map.gatherPositions(startState.position, start_position);
+		const double *start = start_position + (arm == "right" ? EDDIE_HAND_RIGHT : EDDIE_HAND_LEFT);
+
+		// per joint origin and distance to cover, computed once
+		double origin[HandJoints], slope[HandJoints];
+		for (size_t h = 0; h < HandJoints; h++)
+		{
+			origin[h] = is_cart ? start[h] : goalState.joints[h];
+			slope[h] = is_cart ? goalState.joints[h] - start[h] : 0.0;
+		}
 
-		if(arm.compare(std::string("right")) == 0)
-			hand_index = right_hand_index;
-		if(arm.compare(std::string("left")) == 0)
-			hand_index = left_hand_index;
+		// normalised time
+		const double t0 = points.front().time_from_start.toSec();
+		const double duration = points.back().time_from_start.toSec() - t0;
+		const bool timed = duration > 0.0;
+		const double inv_duration = timed ? 1.0/duration : 0.0;
 
-		for (int i = 0; i < NWayPoints ; i++)
+		for (size_t i = 0; i < NWayPoints; i++)
 		{
-			// trajectory_msgs::JointTrajectoryPoint &point = baseTrajectory.joint_trajectory.points[i];
-
-			for(int h = 0; h < pacman::SchunkDexHand::Config::JOINTS; h++)
+			trajectory_msgs::JointTrajectoryPoint &point = points[i];
+
+			const double x = timed ? (point.time_from_start.toSec() - t0)*inv_duration : NWayPoints > 1 ? double(i)/(NWayPoints - 1) : 1.0;
+			double s, ds, dds;
+			handProfile(profile, x, s, ds, dds);
+			const double v = ds*inv_duration, a = dds*inv_duration*inv_duration;
+
+			// one resize per field and point
+			const size_t positions = point.positions.size(), velocities = point.velocities.size(), accelerations = point.accelerations.size();
+			point.positions.resize(positions + HandJoints);
+			point.velocities.resize(velocities + HandJoints);
+			point.accelerations.resize(accelerations + HandJoints);
+			double *pos = point.positions.data() + positions;
+			double *vel = point.velocities.data() + velocities;
+			double *acc = point.accelerations.data() + accelerations;
+			for (size_t h = 0; h < HandJoints; h++)
 			{
-				if( is_cart )
-				  baseTrajectory.joint_trajectory.points[i].positions.push_back(startState.position[hand_index + h] + (i)*( (goalState.joints[h] - startState.position[hand_index + h])/(NWayPoints-1) ) );
-				else
-				  baseTrajectory.joint_trajectory.points[i].positions.push_back( goalState.joints[h] );
-				//baseTrajectory.joint_trajectory.points[i].positions.push_back( goalState.joints[h] );
-	        }
-		
-			baseTrajectory.joint_trajectory.points[i].velocities.push_back(0.0);
-			baseTrajectory.joint_trajectory.points[i].velocities.push_back(0.0);
-			baseTrajectory.joint_trajectory.points[i].velocities.push_back(0.0);
-			baseTrajectory.joint_trajectory.points[i].velocities.push_back(0.0);
-			baseTrajectory.joint_trajectory.points[i].velocities.push_back(0.0);
-			baseTrajectory.joint_trajectory.points[i].velocities.push_back(0.0);
-			baseTrajectory.joint_trajectory.points[i].velocities.push_back(0.0);
-
-			baseTrajectory.joint_trajectory.points[i].accelerations.push_back(0.0);
-			baseTrajectory.joint_trajectory.points[i].accelerations.push_back(0.0);
-			baseTrajectory.joint_trajectory.points[i].accelerations.push_back(0.0);
-			baseTrajectory.joint_trajectory.points[i].accelerations.push_back(0.0);
-			baseTrajectory.joint_trajectory.points[i].accelerations.push_back(0.0);
-			baseTrajectory.joint_trajectory.points[i].accelerations.push_back(0.0);
-			baseTrajectory.joint_trajectory.points[i].accelerations.push_back(0.0);
+				pos[h] = origin[h] + slope[h]*s;
+				vel[h] = slope[h]*v;
+				acc[h] = slope[h]*a;
+			}
 		}
-		//std::cout << "baseTrajectory" << baseTrajectory << std::endl;
+	}
+
+	void interpolateHandJoints(const definitions::SDHand &goalState, const sensor_msgs::JointState &startState, moveit_msgs::RobotTrajectory &baseTrajectory, const std::string &arm, bool is_cart = true, HandProfile profile = HAND_PROFILE_MIN_JERK)
+	{
+		JointStateMap map;
+		interpolateHandJoints(goalState, startState, baseTrajectory, arm, map, is_cart, profile);
 	}
 
 };
@@ -1,6 +1,11 @@
 // system headers
 #include <exception>
+#include <deque>
+#include <algorithm>
 #include <boost/thread.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <pthread.h>
+#include <time.h>
 
 // ros headers
 #include <ros/ros.h>
@@ -11,6 +16,8 @@
 
 // local headers
 #include "definitions/TrajectoryExecution.h"
+#include "definitions/ExecutionProgress.h"
+#include "definitions/PublisherStatistics.h"
 #include <pacman/Bham/Control/Control.h>
 #include <pacman/PaCMan/Defs.h>
 #include <pacman/PaCMan/ROS.h>
@@ -48,9 +55,13 @@ namespace golem_control_bham{
       std::string config_file_;
       std::string arm_name_;
 
-      // ros variables where conversions are saved to
+      // ros variables where conversions are saved to, the names are filled once
       sensor_msgs::JointState joint_states_;
 
+      // joint state publisher rate, by default the controller cycle, and its real-time priority
+      double publish_rate_;
+      int publish_priority_;
+
       // service servers offered by this node
       ros::ServiceServer srv_trajectory_execution_;
       ros::ServiceServer srv_test_uibk_controller_;
@@ -58,17 +69,59 @@ namespace golem_control_bham{
 
       // publishers of this node
       ros::Publisher pub_robot_state_;
+      ros::Publisher pub_publisher_statistics_;
+      ros::Publisher pub_execution_progress_;
+
+      // a trajectory with commands waiting to be streamed to the controller
+      struct StreamSegment
+      {
+        int trajectory_id;
+        int total;
+        // commands still in the queue
+        int queued;
+        // time of the last command
+        pacman::float_t end;
+      };
+
+      // streamed execution: the commands in structure-of-arrays columns, bounded by stream_max_queue_size_, and the trajectories they belong to
+      boost::scoped_ptr<pacman::CommandQueue<RobotEddie::Command> > stream_queue_;
+      std::deque<StreamSegment> stream_segments_;
+      boost::mutex stream_mutex_;
+      boost::condition_variable stream_cond_;
+      boost::thread stream_thread_;
+      // controller time of the last command sent, or being sent
+      pacman::float_t stream_horizon_;
+      // bumped whenever the queued commands are dropped, a chunk taken before that is not sent
+      unsigned stream_generation_;
+
+      // streaming parameters: commands are sent stream_chunk_size_ at a time, whenever less than
+      // stream_lookahead_ seconds of motion are left in the controller
+      int stream_chunk_size_;
+      int stream_max_queue_size_;
+      double stream_lookahead_;
+
+      // loop function of the streaming thread
+      void streamCommands();
+      // drops the queued commands, stream_mutex_ must be locked
+      void clearStream();
 
     public:
     
       // loop function to update the robot state
       void publishRobotState();
+      // publishes the robot state periodically with real-time priority, it never returns
+      void publishRobotStates();
 
       // service function to request trajectory execution
       bool executeTrajectoryFromCode(definitions::TrajectoryExecution::Request &req, definitions::TrajectoryExecution::Response &res);
       bool executeTrajectory(const RobotEddie::Command::Seq &command);
       bool executeTrajectoryNonBlocking(const RobotEddie::Command::Seq &command);
 
+      // queue a trajectory for streamed execution, optionally dropping what is still queued
+      bool streamTrajectory(const definitions::Trajectory &trajectory, bool preempt);
+      // drop the queued commands, the ones already sent are still executed
+      void stopStreaming();
+
       // service function to test the controller
       bool testEddieController(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res);
 
@@ -82,6 +135,15 @@ namespace golem_control_bham{
         // define the names passed in the urdf files corresponding to the current move group
         priv_nh_.param<std::string>("arm_name", arm_name_, "right");
 
+        // streamed execution parameters
+        priv_nh_.param<int>("stream_chunk_size", stream_chunk_size_, 10);
+        priv_nh_.param<int>("stream_max_queue_size", stream_max_queue_size_, 10000);
+        priv_nh_.param<double>("stream_lookahead", stream_lookahead_, 0.5);
+
+        // joint state publisher parameters, a non-positive rate means the controller cycle rate
+        priv_nh_.param<double>("publish_rate", publish_rate_, 0.0);
+        priv_nh_.param<int>("publish_priority", publish_priority_, 50);
+
         // create the controller object using the config file
         controller_ = BhamControl::create(config_file_);
 
@@ -92,14 +154,28 @@ namespace golem_control_bham{
 
         // advertise the node topics
         pub_robot_state_ = nh_.advertise<sensor_msgs::JointState>(nh_.resolveName("/golem/joint_states"), 10);
+        pub_publisher_statistics_ = nh_.advertise<definitions::PublisherStatistics>(nh_.resolveName("/golem/joint_states_statistics"), 10);
+
+        // the joint state message is reused, so the names are set only once
+        pacman::mapStateNames(joint_states_);
+        pub_execution_progress_ = nh_.advertise<definitions::ExecutionProgress>(nh_.resolveName("/golem/execution_progress"), 10);
 
         // initialze the command 
         robot_eddie_command_.resize(1);
 
+        // start feeding the controller
+        stream_queue_.reset(new pacman::CommandQueue<RobotEddie::Command>(std::max(stream_max_queue_size_, 1)));
+        stream_horizon_ = pacman::float_t(0.0);
+        stream_generation_ = 0;
+        stream_thread_ = boost::thread(&GolemController::streamCommands, this);
+
       }
 
-      //! Empty stub
-      ~GolemController() {}
+      ~GolemController()
+      {
+        stream_thread_.interrupt();
+        stream_thread_.join();
+      }
   };
 
 void GolemController::publishRobotState()
@@ -115,7 +191,7 @@ void GolemController::publishRobotState()
   }
 
   // convert from pacman to ros joint states 
-  pacman::mapStates(robot_eddie_state_, joint_states_, ros::Time::now());
+  pacman::mapStatePositions(robot_eddie_state_, joint_states_, ros::Time::now());
 
   // publish the joint states, this functionality could be ported to another node to increase speed and versatility.
   pub_robot_state_.publish(joint_states_);
@@ -123,6 +199,78 @@ void GolemController::publishRobotState()
   return;
 }
 
+void GolemController::publishRobotStates()
+{
+  // a zero period would spin at real-time priority and starve the machine
+  const double default_rate = 100.0;
+  double period = publish_rate_ > 0.0 ? 1.0/publish_rate_ : (double)controller_->cycleDuration();
+  if(!(period >= 1e-6))
+  {
+    ROS_WARN("Invalid joint state publisher period %g s, publishing at %g Hz.", period, default_rate);
+    period = 1.0/default_rate;
+  }
+  const int64_t period_ns = (int64_t)(1e9*period);
+
+  // real-time priority needs the right privileges, without them the publisher still runs at the requested rate
+  struct sched_param param;
+  param.sched_priority = publish_priority_;
+  if(publish_priority_ > 0 && pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+    ROS_WARN("Unable to set the real-time priority %d for the joint state publisher.", publish_priority_);
+  const int64_t window_ns = 1000000000;
+
+  definitions::PublisherStatistics statistics;
+  statistics.target_rate = 1.0/period;
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  int64_t deadline = (int64_t)now.tv_sec*1000000000 + now.tv_nsec;
+  int64_t window_begin = deadline;
+  int samples = 0;
+  double jitter_sum = 0.0;
+
+  while(ros::ok())
+  {
+    // sleep until the absolute deadline, so the time spent publishing does not add up
+    deadline += period_ns;
+    struct timespec wakeup;
+    wakeup.tv_sec = deadline/1000000000;
+    wakeup.tv_nsec = deadline%1000000000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t woke = (int64_t)now.tv_sec*1000000000 + now.tv_nsec;
+    const double jitter = 1e-9*(woke - deadline);
+
+    publishRobotState();
+
+    ++samples;
+    jitter_sum += jitter;
+    statistics.jitter_max = std::max(statistics.jitter_max, jitter);
+    // a late cycle is not caught up: if the next deadline has already passed, the schedule restarts from now,
+    // otherwise the thread would never sleep again at real-time priority
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t done = (int64_t)now.tv_sec*1000000000 + now.tv_nsec;
+    if(done >= deadline + period_ns)
+    {
+      ++statistics.overruns;
+      deadline = done;
+    }
+
+    if(woke - window_begin >= window_ns)
+    {
+      statistics.rate = samples/(1e-9*(woke - window_begin));
+      statistics.jitter_mean = jitter_sum/samples;
+      pub_publisher_statistics_.publish(statistics);
+
+      window_begin = woke;
+      samples = 0;
+      jitter_sum = 0.0;
+      statistics.jitter_max = 0.0;
+      statistics.overruns = 0;
+    }
+  }
+}
+
 bool GolemController::executeTrajectoryFromCode(definitions::TrajectoryExecution::Request &req, definitions::TrajectoryExecution::Response &res)
 {
 
@@ -133,6 +281,22 @@ bool GolemController::executeTrajectoryFromCode(definitions::TrajectoryExecution
 
   definitions::Trajectory trajectory = req.trajectory;
 
+  // streamed execution returns as soon as the trajectory is queued
+  if(req.stream != req.STREAM_NONE)
+  {
+    if( streamTrajectory(trajectory, req.stream == req.STREAM_PREEMPT) )
+    {
+      ROS_INFO("Trajectory %d queued for streaming.", trajectory.trajectory_id);
+      res.result = res.SUCCESS;
+      return true;
+    }
+    ROS_ERROR("Trajectory %d couldn't be queued for streaming.", trajectory.trajectory_id);
+    return false;
+  }
+
+  // a direct execution replaces whatever is still streaming
+  stopStreaming();
+
   //convert the trajectory to the command ToDo: double check that the trajectory has velocity and acceleration
   pacman::convert(trajectory, robot_eddie_command_, controller_->time());
 
@@ -199,6 +363,138 @@ bool GolemController::executeTrajectoryNonBlocking(const RobotEddie::Command::Se
   return true;
 }
 
+bool GolemController::streamTrajectory(const definitions::Trajectory &trajectory, bool preempt)
+{
+  boost::mutex::scoped_lock lock(stream_mutex_);
+
+  if(preempt)
+    clearStream();
+
+  if(stream_queue_->size() + trajectory.eddie_path.size() > stream_queue_->getCapacity())
+  {
+    ROS_ERROR("The streaming queue can not take %lu more commands, %lu are still queued.", trajectory.eddie_path.size(), (unsigned long)stream_queue_->size());
+    return false;
+  }
+
+  // the trajectory starts after the last queued command, or after the last one sent if nothing is queued
+  pacman::float_t start = std::max(controller_->time(), stream_segments_.empty() ? stream_horizon_ : stream_segments_.back().end);
+
+  RobotEddie::Command::Seq commands;
+  pacman::convert(trajectory, commands, start);
+  if(commands.empty())
+    return true;
+
+  for(size_t i = 0; i < commands.size(); ++i)
+    stream_queue_->push(commands[i]);
+  StreamSegment segment;
+  segment.trajectory_id = trajectory.trajectory_id;
+  segment.total = segment.queued = (int)commands.size();
+  segment.end = commands.back().t;
+  stream_segments_.push_back(segment);
+
+  lock.unlock();
+  stream_cond_.notify_one();
+
+  return true;
+}
+
+void GolemController::stopStreaming()
+{
+  boost::mutex::scoped_lock lock(stream_mutex_);
+  clearStream();
+}
+
+void GolemController::clearStream()
+{
+  stream_queue_->clear();
+  stream_segments_.clear();
+  ++stream_generation_;
+}
+
+void GolemController::streamCommands()
+{
+  RobotEddie::Command::Seq chunk;
+  chunk.reserve(stream_chunk_size_);
+  definitions::ExecutionProgress progress;
+  unsigned generation = 0;
+  pacman::float_t horizon = pacman::float_t(0.0);
+  const boost::posix_time::milliseconds poll(std::max(1, (int)(1000.0*stream_lookahead_/4.0)));
+
+  try
+  {
+    while(ros::ok())
+    {
+      {
+        boost::mutex::scoped_lock lock(stream_mutex_);
+
+        // wait for queued commands, and until the controller runs short of the ones already sent
+        while(ros::ok() && (stream_queue_->size() == 0 || stream_horizon_ - controller_->time() > stream_lookahead_))
+          stream_cond_.timed_wait(lock, poll);
+        // shutting down, the queued commands are dropped
+        if(!ros::ok())
+          break;
+
+        // the oldest queued commands which are contiguous in the queue columns, converted back for the controller
+        const pacman::CommandQueue<RobotEddie::Command>::View view = stream_queue_->front();
+        const int size = (int)std::min(view.size, (std::uintptr_t)std::max(stream_chunk_size_, 1));
+        chunk.resize(size);
+        for(int i = 0; i < size; ++i)
+          view.get(i, chunk[i]);
+        stream_queue_->pop(size);
+
+        // progress of the trajectories the chunk belongs to
+        for(int taken = size; taken > 0 && !stream_segments_.empty();)
+        {
+          StreamSegment &segment = stream_segments_.front();
+          const int n = std::min(taken, segment.queued);
+          segment.queued -= n;
+          taken -= n;
+          progress.trajectory_id = segment.trajectory_id;
+          progress.sent = segment.total - segment.queued;
+          progress.total = segment.total;
+          if(segment.queued == 0)
+            stream_segments_.pop_front();
+        }
+        progress.queued = (int)stream_queue_->size();
+
+        // the chunk counts as sent from now on, so a trajectory appended while it is sent is timed after it
+        generation = stream_generation_;
+        horizon = stream_horizon_;
+        stream_horizon_ = chunk.back().t;
+        progress.horizon = stream_horizon_;
+      }
+
+      // sent unlocked, so trajectories can be appended or preempted while send() waits for room in the controller queue;
+      // a chunk preempted since it was taken is dropped, one already handed to the controller is still executed
+      {
+        boost::mutex::scoped_lock lock(stream_mutex_);
+        if(generation != stream_generation_)
+          continue;
+      }
+      try
+      {
+        controller_->send(chunk.data(), chunk.size());
+      }
+      catch (const std::exception& ex)
+      {
+        ROS_ERROR("Unable to stream the trajectory, dropping the queued commands: %s\n", ex.what());
+        boost::mutex::scoped_lock lock(stream_mutex_);
+        if(generation == stream_generation_)
+        {
+          clearStream();
+          stream_horizon_ = horizon;
+        }
+        continue;
+      }
+
+      pub_execution_progress_.publish(progress);
+    }
+  }
+  catch (const boost::thread_interrupted&)
+  {
+  }
+}
+
 bool GolemController::testEddieController(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res)
 {
     try
@@ -278,11 +574,8 @@ bool GolemController::testEddieController(std_srvs::Empty::Request &req, std_srv
 
 void publishThread_fnc(golem_control_bham::GolemController &nn)
 {
-  while(ros::ok())
-  {
-    // publish joint states
-    nn.publishRobotState();
-  }
+  // publish joint states at the controller rate
+  nn.publishRobotStates();
   return;
 }
 
@@ -307,8 +600,8 @@ int main(int argc, char **argv)
   // and we need to continuously pusblish the joint state to visualize whats going on
   // so instead of the typical while loop with ros::spin(), we need to split 
   // the control and the publishing into two threads.
-  boost::thread publish_thread( publishThread_fnc, node );
-  boost::thread control_thread( controlThread_fnc, node );
+  boost::thread publish_thread( publishThread_fnc, boost::ref(node) );
+  boost::thread control_thread( controlThread_fnc, boost::ref(node) );
   publish_thread.join();
   control_thread.join();
 
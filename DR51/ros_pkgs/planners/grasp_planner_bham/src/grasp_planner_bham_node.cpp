@@ -51,6 +51,9 @@ class GraspPlanner
 	// path to the database
 	std::string path_to_database_;
 
+	// grasps below the elevation and unlikely candidates are dropped before ranking
+	pacman::BhamGrasp::Selection selection_;
+
 	// test files
 	// only for testing
 	std::string pcd_file_;
@@ -88,6 +91,9 @@ class GraspPlanner
 
 		nh_.param<std::string>("path_to_DB",path_to_database_,"/home/pacman/Code/pacman/poseEstimation/dataFiles/PCD-MODELS-DOWNSAMPLED/");
 
+		// faster grasp estimation, it changes the grasp likelihoods
+		nh_.param<bool>("prefilter_grasps", selection_.prefilter, false);
+
 		// create the grasp object using the config file
 		grasp_ = pacman::BhamGrasp::create(config_file_);
 
@@ -195,7 +201,7 @@ bool GraspPlanner::planGrasp(definitions::GraspPlanning::Request  &req, definiti
 	// ESTIMATE
 	// clear the member before calling the estimate again
 	planned_grasps_.clear();
-	grasp_->estimate(object_pacman, planned_grasps_);
+	grasp_->estimate(object_pacman, selection_, planned_grasps_);
 	
 	ROS_INFO("Number of planned grasps %ld",planned_grasps_.size());
 	
@@ -42,6 +42,9 @@ class HeadPlanner
     // joint state topic
     std::string joint_state_topic_;
 
+    // the joints of the joint state messages found by name, rebuilt only when their layout changes
+    pacman::JointStateMap joint_state_map_;
+
     // thread for think motion
     pthread_t thread_;
     boost::posix_time::ptime t_;
@@ -105,7 +108,17 @@ bool HeadPlanner::moveHead(definitions::MoveHead::Request &request, definitions:
         return false;
         // ROS_ERROR("Planning will be done from home position, however this trajectory might not be good for execution!");
     }
-    sensor_msgs::JointState startJointState = *current_state_ptr;
+    // every waypoint starts from the current state, converted once
+    definitions::RobotEddie startEddie;
+    try
+    {
+        pacman::convertJointStateToEddie( *current_state_ptr, startEddie, joint_state_map_ );
+    }
+    catch (const std::runtime_error &e)
+    {
+        ROS_ERROR("%s", e.what());
+        return false;
+    }
 
     definitions::Trajectory head_trajectory;
 
@@ -118,7 +131,7 @@ bool HeadPlanner::moveHead(definitions::MoveHead::Request &request, definitions:
 
         for (int i = 0; i < head_trajectory.eddie_path.size(); i++)
         {
-            pacman::convertJointStateToEddie( startJointState, head_trajectory.eddie_path.at(i) );
+            head_trajectory.eddie_path.at(i) = startEddie;
             head_trajectory.eddie_path.at(i).head.joints.at(0) = 0;
             head_trajectory.eddie_path.at(i).head.joints.at(1) = 0;
             head_trajectory.eddie_path.at(i).head.joints.at(2) = 0;
@@ -167,7 +180,7 @@ bool HeadPlanner::moveHead(definitions::MoveHead::Request &request, definitions:
 
         for (int i = 0; i < head_trajectory.eddie_path.size(); i++)
         {
-            pacman::convertJointStateToEddie( startJointState, head_trajectory.eddie_path.at(i) );
+            head_trajectory.eddie_path.at(i) = startEddie;
         }
 
         // // // // to implement
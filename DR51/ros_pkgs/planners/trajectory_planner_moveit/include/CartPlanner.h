@@ -1,7 +1,14 @@
-//// ros headers 
+//// system headers
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <list>
+#include <map>
+
+//// ros headers
 #include <ros/ros.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <moveit_msgs/GetMotionPlan.h>
+#include <moveit_msgs/GetCartesianPath.h>
 #include <moveit_msgs/DisplayTrajectory.h>
 #include <moveit_msgs/AttachedCollisionObject.h>
 #include <moveit/kinematic_constraints/utils.h>
@@ -9,6 +16,7 @@
 //// local headers
 #include <definitions/TrajectoryPlanning.h>
 #include <KinematicsHelper.h>
+#include <JointStateCache.h>
 
 namespace trajectory_planner_moveit {
 
@@ -17,15 +25,90 @@ class CartPlanner
 {
   private:
 
-    // clients
-    ros::ServiceClient clt_moveit_planning_;
+    // the planning attempts run concurrently, so every service call creates its own client from these
+    ros::NodeHandle nh_;
+    std::string planning_service_name_;
+    std::string cartesian_service_name_;
+
+    // the ik client is shared, its calls are serialised
     KinematicsHelper ki_helper_;
+    boost::mutex ki_mutex_;
+
+    // pose reference frame and end effector link of each arm group, read once at start-up
+    std::map<std::string, std::string> pose_frames_;
+    std::map<std::string, std::string> eef_links_;
 
 	// the variable where the plans are stored
 	std::vector<moveit_msgs::MotionPlanResponse> motion_plans_;
 	ros::Subscriber sub_collision_objects_;
 	std::vector<moveit_msgs::AttachedCollisionObject> collision_objects_;
-   
+
+	// everything a single request needs, so the concurrent planning attempts
+	// never touch planner members that the next request may change
+	struct Request
+	{
+		std::string arm;
+		std::string group_name;
+		std::string plan_for_frame;
+		// frame of the wrist goal and the link following it in the cartesian path
+		std::string pose_frame;
+		std::string eef_link;
+		sensor_msgs::JointState start_state;
+		definitions::SDHand goal_hand;
+		std::vector<moveit_msgs::AttachedCollisionObject> collision_objects;
+	};
+
+	// outcome of one planning attempt
+	struct Attempt
+	{
+		bool done;
+		bool success;
+		definitions::TrajectoryPlanning::Response response;
+
+		Attempt() : done(false), success(false) {}
+	};
+
+	// shared by the attempts of a request, the first valid plan wins
+	struct Race
+	{
+		boost::mutex mutex;
+		boost::condition_variable cond;
+		Attempt cartesian;
+		Attempt fallback;
+		bool abort;
+
+		Race() : abort(false) {}
+	};
+
+	// a running attempt, kept until it is joined
+	struct Worker
+	{
+		boost::shared_ptr<boost::thread> thread;
+		boost::shared_ptr<Race> race;
+	};
+
+	// the attempts which may still be running, including the losers of the previous requests
+	std::list<Worker> workers_;
+
+	// the two competing attempts, each one runs in its own thread
+	void runCartesian(boost::shared_ptr<Race> race, boost::shared_ptr<const Request> req);
+	void runFallback(boost::shared_ptr<Race> race, boost::shared_ptr<const Request> req);
+	void finish(Race &race, Attempt &attempt, bool success);
+	// true once the request has been answered and the remaining attempts should stop
+	bool aborted(Race &race);
+	// starts an attempt and keeps track of its thread
+	void start(void (CartPlanner::*attempt)(boost::shared_ptr<Race>, boost::shared_ptr<const Request>), boost::shared_ptr<Race> race, boost::shared_ptr<const Request> req);
+	// joins the attempts which have already finished
+	void reap();
+
+	// reads the frames of the arm groups
+	void readFrames();
+
+	// search for the smallest jump threshold that covers the whole path, returns the best fraction found
+	double searchCartesianPath(const Request &req, Race &race, moveit_msgs::RobotTrajectory &trajectory);
+	// a single call to the cartesian path service for the given jump threshold
+	void computeCartesianPath(const Request &req, double jump_threshold, moveit_msgs::RobotTrajectory &trajectory, double &fraction);
+
   public:
 
   	// planning related parameters
@@ -35,47 +118,53 @@ class CartPlanner
 	double tolerance_in_position_;
 	double tolerance_in_orientation_;
 	double eef_step_;
-	double jump_threshold_;
 	int min_traj_size_;
 
+	// the jump threshold search: candidates go from jump_threshold_ up to max_jump_threshold_
+	// growing by jump_threshold_factor_, and up to search_width_ of them are tried at once
+	double jump_threshold_;
+	double max_jump_threshold_;
+	double jump_threshold_factor_;
+	int search_width_;
+
     // define the names passed in the urdf files corresponding to the current move group for planning
-    std::string group_name_;
     std::string base_frame_for_goal_;
-	std::string plan_for_frame_;
 
-	// joint state topic
-	std::string topic_;
+	// the latest joint state of the robot, shared by all planners
+	JointStateCachePtr joint_states_;
 
 	// speed scale for trajectory
 	double speed_;
 
 	ros::Publisher display_publisher_;
 
-  	// the service callback 
+  	// the service callback
   	bool planTrajectoryFromCode(definitions::TrajectoryPlanning::Request &request, definitions::TrajectoryPlanning::Response &response);
 
   	// the actual planning function
-  	// first, carlos' configuration is tried, and 
-  	// if it doesn't find a plan, then, martin's
-  	// config is tried
+  	// carlos' configuration is tried on top of the cartesian path, and
+  	// martin's configuration is tried at the same time as a fallback,
+  	// the first one to find a plan is used
   	// implements carlos' configuration of moveit
-  	bool planTrajectory(std::vector<definitions::Trajectory> &trajectories, moveit_msgs::Constraints &goal, std::string &arm, sensor_msgs::JointState &startState, definitions::SDHand &goal_hand);
-  	// implements martin's configuration of moveit
-  	bool planTrajectoryUIBK(std::vector<definitions::Trajectory> &trajectories, definitions::SDHand &goal, std::string &arm, sensor_msgs::JointState &startState, definitions::TrajectoryPlanning::Response &response);
+  	bool planTrajectory(std::vector<definitions::Trajectory> &trajectories, moveit_msgs::Constraints &goal, const Request &req);
+  	// implements martin's configuration of moveit, gives up as soon as the race is aborted
+  	bool planTrajectoryUIBK(std::vector<definitions::Trajectory> &trajectories, const Request &req, Race &race, definitions::TrajectoryPlanning::Response &response);
 
   	// helper to attach collision objects
     void callback_collision_object(const moveit_msgs::AttachedCollisionObject &object);
 
     // constructor
-    CartPlanner(ros::NodeHandle nh) : ki_helper_(nh)
+    CartPlanner(ros::NodeHandle nh, JointStateCachePtr joint_states) : nh_(nh), ki_helper_(nh), joint_states_(joint_states)
     {
 
 		// wait for moveit to load
-		std::string planning_service_name = "/plan_kinematic_path";
+		planning_service_name_ = "/plan_kinematic_path";
+		cartesian_service_name_ = "/compute_cartesian_path";
 
 		ROS_INFO("Waiting for MoveIt! to fully load...");
-		ros::service::waitForService(planning_service_name, -1);
-		clt_moveit_planning_ = nh.serviceClient<moveit_msgs::GetMotionPlan>(planning_service_name);
+		ros::service::waitForService(planning_service_name_, -1);
+		ros::service::waitForService(cartesian_service_name_, -1);
+		readFrames();
 
 		// planning related parameters default
 		max_points_in_trajectory_ = 60;
@@ -85,9 +174,9 @@ class CartPlanner
 		tolerance_in_orientation_ = 0.01;
 		eef_step_ = 0.1; // to avoid jumps in the cartesian interpolation
 		jump_threshold_ = 5.0; // to avoid jumps in the ik solution
-
-		// joint state topic
-		topic_ = nh.resolveName("/joint_states");
+		max_jump_threshold_ = 100.0;
+		jump_threshold_factor_ = 1.1;
+		search_width_ = 4;
 
 		// to double the speed of the trajectory
 		speed_ = 1.0;
@@ -97,8 +186,8 @@ class CartPlanner
 		min_traj_size_ = 10;
     }
 
-    //! Empty stub
-    ~CartPlanner() {}
+    // stops the remaining attempts and waits for them
+    ~CartPlanner();
 
 };
 
@@ -0,0 +1,89 @@
+#ifndef JOINTSTATECACHE_H
+#define JOINTSTATECACHE_H
+
+//// system headers
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+
+//// ros headers
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <sensor_msgs/JointState.h>
+
+//// local headers
+
+
+namespace trajectory_planner_moveit {
+
+/**
+ * @brief The JointStateCache class
+ *
+ * Always-on subscriber that keeps the latest joint state of the robot, shared by all planners.
+ *
+ * The subscription is served by its own callback queue and spinner, so the cache keeps
+ * updating while a planning service callback is blocking the main spin loop.
+ * Readers get the last received message without taking a lock and without copying it.
+ */
+class JointStateCache {
+
+private:
+	// the last message together with the time it was received
+	struct Sample
+	{
+		sensor_msgs::JointStateConstPtr state;
+		ros::Time received;
+	};
+
+	ros::CallbackQueue queue_;
+	boost::scoped_ptr<ros::AsyncSpinner> spinner_;
+	ros::Subscriber sub_joint_states_;
+
+	// only ever swapped atomically, never modified in place
+	boost::shared_ptr<const Sample> sample_;
+
+	void callback_joint_states(const sensor_msgs::JointStateConstPtr &state);
+
+public:
+
+	// joint state topic
+	std::string topic_;
+
+	// states older than this are considered stale
+	ros::Duration max_age_;
+
+	JointStateCache(ros::NodeHandle &nh, const std::string &topic = "/joint_states", const ros::Duration &max_age = ros::Duration(0.5));
+	~JointStateCache();
+
+	/**
+	 * @brief get
+	 *
+	 * Latest joint state, if it is not older than max_age_.
+	 *
+	 * @return the cached message, or an empty pointer if there is none or it is stale
+	 */
+	sensor_msgs::JointStateConstPtr get() const;
+
+	/**
+	 * @brief get
+	 *
+	 * Latest joint state, waiting up to timeout for a fresh one if the cache is empty or stale.
+	 * The first call of a request with a fresh cache returns immediately.
+	 *
+	 * @param timeout how long to wait for a fresh joint state
+	 * @return the cached message, or an empty pointer if none arrived in time
+	 */
+	sensor_msgs::JointStateConstPtr get(const ros::Duration &timeout) const;
+
+	/**
+	 * @brief age
+	 * @return time since the latest joint state was received, negative if none was received yet
+	 */
+	ros::Duration age() const;
+
+};
+
+typedef boost::shared_ptr<JointStateCache> JointStateCachePtr;
+
+}
+
+#endif // JOINTSTATECACHE_H
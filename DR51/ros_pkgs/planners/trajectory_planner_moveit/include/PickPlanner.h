@@ -9,6 +9,7 @@
 //// local headers
 #include <definitions/TrajectoryPlanning.h>
 #include "KinematicsHelper.h"
+#include "JointStateCache.h"
 
 namespace trajectory_planner_moveit {
 
@@ -42,8 +43,8 @@ class PickPlanner
     std::string base_frame_for_goal_;
 	std::string plan_for_frame_;
 
-	// joint state topic
-	std::string topic_;
+	// the latest joint state of the robot, shared by all planners
+	JointStateCachePtr joint_states_;
 
 	// speed scale for trajectory
 	double speed_;
@@ -55,7 +56,7 @@ class PickPlanner
   	bool planTrajectoryFromCode(definitions::TrajectoryPlanning::Request &request, definitions::TrajectoryPlanning::Response &response);
 
     // constructor
-    PickPlanner(ros::NodeHandle nh) : ki_helper_(nh)
+    PickPlanner(ros::NodeHandle nh, JointStateCachePtr joint_states) : ki_helper_(nh), joint_states_(joint_states)
     {
 
 		// wait for moveit to load
@@ -74,9 +75,6 @@ class PickPlanner
 		// (in some complicated manner)
 		eef_step_ = 10; // to avoid jumps in the cartesian interpolation
 		jump_threshold_ = 5.0; // to avoid jumps in the ik solution
-
-		// joint state topic
-		topic_ = nh.resolveName("/joint_states");
 		
 // 		display_publisher_ = nh.advertise<moveit_msgs::DisplayTrajectory>("/move_group/display_planned_path", 1, true);
 		display_publisher_ = nh.advertise<moveit_msgs::DisplayRobotState>("/display_robot_state", 1, true);
@@ -6,6 +6,7 @@
 
 //// local headers
 #include <definitions/TrajectoryPlanning.h>
+#include "JointStateCache.h"
 
 namespace trajectory_planner_moveit {
 
@@ -35,8 +36,8 @@ class StatePlanner
 	std::string plan_for_frame_;
 	int min_traj_size_;
 
-	// joint state topic
-	std::string topic_;
+	// the latest joint state of the robot, shared by all planners
+	JointStateCachePtr joint_states_;
 
 	// speed scale for trajectory
 	double speed_;
@@ -48,7 +49,7 @@ class StatePlanner
     bool planTrajectory(std::vector<definitions::Trajectory> &trajectories, definitions::RobotEddie &goal, std::string &arm, sensor_msgs::JointState &startState);
 
     // constructor
-    StatePlanner(ros::NodeHandle nh)
+    StatePlanner(ros::NodeHandle nh, JointStateCachePtr joint_states) : joint_states_(joint_states)
     {
 
 		// wait for moveit to load
@@ -66,9 +67,6 @@ class StatePlanner
 		tolerance_in_orientation_ = 0.01;
 		min_traj_size_ = 10;
 
-		// joint state topic
-		topic_ = nh.resolveName("/joint_states");
-
 		// to double the speed of the trajectory
 		speed_ = 1.0;
     }
@@ -18,6 +18,7 @@
 #include <definitions/TrajectoryPlanning.h>
 
 //// local headers
+#include "JointStateCache.h"
 
 
 #define CAN_LOOK false
@@ -48,7 +49,8 @@ private:
     string planner_id_;
     string support_surface_;
 
-    string joint_states_topic_;
+    // the latest joint state of the robot, shared by all planners
+    JointStateCachePtr joint_states_;
 
     /**
      * Compute gripper translation from given start and goal poses.
@@ -101,7 +103,7 @@ private:
     void fillTrajectory(const string &arm, trajectory_msgs::JointTrajectory &t, const definitions::SDHand &hand);
 
 public:
-    PickupPlanner(ros::NodeHandle &nh);
+    PickupPlanner(ros::NodeHandle &nh, JointStateCachePtr joint_states);
     virtual ~PickupPlanner() {}
 
     bool planPickup(TrajectoryPlanning::Request &request, TrajectoryPlanning::Response &response);
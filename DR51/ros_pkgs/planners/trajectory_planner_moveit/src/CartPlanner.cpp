@@ -1,5 +1,8 @@
 //// system headers
 #include <boost/shared_ptr.hpp> 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <algorithm>
 
 //// ros headers 
 #include <ros/ros.h>
@@ -30,31 +33,29 @@ bool CartPlanner::planTrajectoryFromCode(definitions::TrajectoryPlanning::Reques
 		ROS_INFO("Received cartesian planning request");
 		ros::Time now = ros::Time::now();
 
-		// this is were the response will be filled
-		std::vector<definitions::Trajectory> &trajectories = response.trajectory;
+		// the losers of the previous requests which have finished in the meantime
+		reap();
 
-		// wait for a joint state to read the current state
-		boost::shared_ptr<const sensor_msgs::JointState> current_state_ptr = ros::topic::waitForMessage<sensor_msgs::JointState>(topic_, ros::Duration(3.0));
+		// read the current state, only waits if the cached one is stale
+		sensor_msgs::JointStateConstPtr current_state_ptr = joint_states_->get(ros::Duration(3.0));
 		if (!current_state_ptr)
 		{
-			ROS_ERROR("No real start state available, since no joint state recevied in topic: %s", topic_.c_str());
+			ROS_ERROR("No real start state available, since no joint state recevied in topic: %s", joint_states_->topic_.c_str());
 			ROS_ERROR("Did you forget to start a controller?");
 			response.result = response.OTHER_ERROR;
 			return false;
 			// ROS_ERROR("Planning will be done from home position, however this trajectory might not be good for execution!");
 		}
-		sensor_msgs::JointState startJointState = *current_state_ptr;
-		moveit_msgs::RobotState start_state;
-		start_state.joint_state = startJointState;
 
-		// plan for the given wrist goal
-		definitions::SDHand goal_hand;
+		// everything the planning attempts need is copied into the request state
+		boost::shared_ptr<Request> req(new Request);
+		req->start_state = *current_state_ptr;
 
 		// note that we plan for wrist frame of the requested arm
 		if(request.arm.compare(std::string("right")) == 0)
-			goal_hand = request.eddie_goal_state.handRight;
+			req->goal_hand = request.eddie_goal_state.handRight;
 		else if(request.arm.compare(std::string("left")) == 0)
-			goal_hand = request.eddie_goal_state.handLeft;
+			req->goal_hand = request.eddie_goal_state.handLeft;
 		else
 		{
 			ROS_ERROR("The request.arm string should either be \"right\" or \"left\", while it is now \"%s\"", request.arm.c_str());
@@ -63,112 +64,42 @@ bool CartPlanner::planTrajectoryFromCode(definitions::TrajectoryPlanning::Reques
 		}
 
 		// set the group
-		group_name_ = request.arm + "_arm";
-		plan_for_frame_ = request.arm + "_sdh_palm_link";
-		move_group_interface::MoveGroup arm_group( group_name_.c_str() );
-
-		/// PATH APPROACH; IT MISSES THE TRAJECTORY COMPUTATION
-		// now we plan move to the goal pose
-		std::vector<geometry_msgs::Pose> waypoints;
-		waypoints.push_back(goal_hand.wrist_pose.pose);
-
-		moveit_msgs::RobotTrajectory moveit_trajectory;
-		bool avoid_collisions = true;
-
-		// setting the planner and general parameters
-		arm_group.setPlannerId("PRMstarkConfigDefault");
-		arm_group.setGoalPositionTolerance(tolerance_in_position_);
-		arm_group.setGoalOrientationTolerance(tolerance_in_orientation_);
-		arm_group.setPlanningTime(max_planning_time_);
-
-		// set the current state
-		arm_group.setStartState(start_state);
-		
-		// and compute the cartesian path
-		// fraction means the fraction of the path covered
-		// since we have only one waypoint, the fraction must be on or very close to one
-		// if not, it means it couldn't find a safe goal position
-		double fraction = 0.0;
-		while( (fraction < 0.99) && (jump_threshold_ < 100) )
-		{
-			fraction = arm_group.computeCartesianPath(waypoints, eef_step_, jump_threshold_, moveit_trajectory, avoid_collisions);
-			jump_threshold_ = jump_threshold_*1.1;
-			if (fraction < 1.00)
-			{
-				ROS_INFO("Only %f part of the path could be computed", fraction);
-				ROS_INFO("Increasing 10 percent the jump threshold in computeCartesianPath");
-			}
-		}
-		// initialize jump threshold again for future requests
-		jump_threshold_ = 5.0;
-		
-		if (fraction < 1.0)
+		req->arm = request.arm;
+		req->group_name = request.arm + "_arm";
+		req->plan_for_frame = request.arm + "_sdh_palm_link";
+		req->pose_frame = pose_frames_[req->arm];
+		req->eef_link = eef_links_[req->arm];
+
+		// the attached objects are consumed by this request
+		req->collision_objects = collision_objects_;
+		collision_objects_.clear();
+
+		// martin's configuration is started right away, so it is ready if the cartesian path fails;
+		// both attempts keep the race and the request alive, so the loser can finish on its own
+		boost::shared_ptr<Race> race(new Race);
+		start(&CartPlanner::runFallback, race, req);
+		start(&CartPlanner::runCartesian, race, req);
+
+		// wait for the first valid plan, or for both attempts to fail
+		boost::mutex::scoped_lock lock(race->mutex);
+		while (!race->cartesian.success && !race->fallback.success && !(race->cartesian.done && race->fallback.done))
+			race->cond.wait(lock);
+		race->abort = true;
+
+		if (race->cartesian.success)
+			response = race->cartesian.response;
+		else if (race->fallback.success)
+			response = race->fallback.response;
+		else
 		{
-			ROS_WARN("The goal configuration can not be reached easily, for the MOVE_TO_CART_GOAL, trying other approach");
-  			if (!planTrajectoryUIBK(trajectories, goal_hand, request.arm, startJointState, response) )
-			{
-				ROS_WARN("No trajectory found for the required goal state");
-				response.result = response.NO_FEASIBLE_TRAJECTORY_FOUND;
-				return false;
-			}
+			ROS_WARN("No trajectory found for the required goal state");
+			response.result = race->fallback.response.result;
 			return false;
 		}
 
-  		if(trajectory_processing::isTrajectoryEmpty(moveit_trajectory))
-  		{
-  			return false;
-  		}
-  		else
-  		{
-  			ROS_INFO("Sucessfully found a good goal position for the MOVE_TO_CART_GOAL");
-
-			//display the path to check that the found goal position is good
-			// moveit_msgs::DisplayTrajectory display_trajectory;
-			// display_trajectory.trajectory_start = start_state;
-			// display_trajectory.trajectory.push_back(moveit_trajectory);
-			// display_publisher_.publish(display_trajectory);
-		
-			trajectory_msgs::JointTrajectoryPoint goal_point;
-
-			goal_point = moveit_trajectory.joint_trajectory.points[moveit_trajectory.joint_trajectory.points.size()-1];
-
-			// build the joint constraint out of the goal point
-			moveit_msgs::Constraints goal_state;
-			moveit_msgs::JointConstraint joint_constraint;
-			for (int i=0; i<goal_point.positions.size(); i++ )
-			{
-				joint_constraint.joint_name = moveit_trajectory.joint_trajectory.joint_names[i];
-				joint_constraint.position = goal_point.positions[i];
-				joint_constraint.weight = 1.0;
-				// tolerances of 0.0 above and below are the default anyway
-				// joint_constraint.tolerance_above = 0.0;
-				// joint_constraint.tolerance_below = 0.0;
-				goal_state.joint_constraints.push_back(joint_constraint);
-			}
-
-			if( !planTrajectory(trajectories, goal_state, request.arm, startJointState, goal_hand) || trajectories.size() < 1 ) 
-			{
-				if (!planTrajectoryUIBK(trajectories, goal_hand, request.arm, startJointState, response) )
-				{
-					ROS_WARN("No trajectory found for the required goal state");
-					//response.result = response.NO_FEASIBLE_TRAJECTORY_FOUND;
-					return false;
-				}
-			}
-			else
-			{
-				//ROS_INFO("trajectories.size() %lu",trajectories.size());
-				//ROS_INFO("trajectories.at(trajectories.size()-1).eddie_path.size() %lu",trajectories.at(trajectories.size()-1).eddie_path.size());
-				
-				response.result = response.SUCCESS;
-				ros::Duration duration = ros::Time::now() - now;
-
-				ROS_INFO("Trajectory planning request completed");
-				ROS_INFO_STREAM("Total trajectory calculation took " << duration);
-				return true;
-			}
-  		}
-
+		ROS_INFO("Trajectory planning request completed");
+		ROS_INFO_STREAM("Total trajectory calculation took " << ros::Time::now() - now);
+		return true;
 	}
 	else
 	{
@@ -178,14 +109,203 @@ bool CartPlanner::planTrajectoryFromCode(definitions::TrajectoryPlanning::Reques
 
 }
 
+CartPlanner::~CartPlanner()
+{
+	for (std::list<Worker>::iterator i = workers_.begin(); i != workers_.end(); ++i)
+	{
+		boost::mutex::scoped_lock lock(i->race->mutex);
+		i->race->abort = true;
+	}
+	// a service call in progress is not interrupted, the attempt stops right after it
+	for (std::list<Worker>::iterator i = workers_.begin(); i != workers_.end(); ++i)
+		i->thread->join();
+}
+
+void CartPlanner::readFrames()
+{
+	const char *arms[] = {"right", "left"};
+	for (size_t i = 0; i < sizeof(arms)/sizeof(arms[0]); ++i)
+	{
+		move_group_interface::MoveGroup arm_group(std::string(arms[i]) + "_arm");
+		pose_frames_[arms[i]] = arm_group.getPoseReferenceFrame();
+		eef_links_[arms[i]] = arm_group.getEndEffectorLink();
+	}
+}
+
+void CartPlanner::start(void (CartPlanner::*attempt)(boost::shared_ptr<Race>, boost::shared_ptr<const Request>), boost::shared_ptr<Race> race, boost::shared_ptr<const Request> req)
+{
+	Worker worker;
+	worker.race = race;
+	worker.thread.reset(new boost::thread(attempt, this, race, req));
+	workers_.push_back(worker);
+}
+
+void CartPlanner::reap()
+{
+	for (std::list<Worker>::iterator i = workers_.begin(); i != workers_.end();)
+	{
+		if (i->thread->timed_join(boost::posix_time::seconds(0)))
+			i = workers_.erase(i);
+		else
+			++i;
+	}
+}
+
+bool CartPlanner::aborted(Race &race)
+{
+	boost::mutex::scoped_lock lock(race.mutex);
+	return race.abort;
+}
+
+void CartPlanner::finish(Race &race, Attempt &attempt, bool success)
+{
+	{
+		boost::mutex::scoped_lock lock(race.mutex);
+		attempt.done = true;
+		attempt.success = success;
+	}
+	race.cond.notify_all();
+}
+
+void CartPlanner::runFallback(boost::shared_ptr<Race> race, boost::shared_ptr<const Request> req)
+{
+	definitions::TrajectoryPlanning::Response response;
+	response.result = response.NO_FEASIBLE_TRAJECTORY_FOUND;
+	bool success = planTrajectoryUIBK(response.trajectory, *req, *race, response);
+	if (success)
+		response.result = response.SUCCESS;
+
+	race->fallback.response = response;
+	finish(*race, race->fallback, success);
+}
+
+void CartPlanner::runCartesian(boost::shared_ptr<Race> race, boost::shared_ptr<const Request> req)
+{
+	// and compute the cartesian path
+	// fraction means the fraction of the path covered
+	// since we have only one waypoint, the fraction must be one
+	// if not, it means it couldn't find a safe goal position
+	moveit_msgs::RobotTrajectory moveit_trajectory;
+	double fraction = searchCartesianPath(*req, *race, moveit_trajectory);
+
+	if (fraction < 1.0 || trajectory_processing::isTrajectoryEmpty(moveit_trajectory))
+	{
+		ROS_WARN("The goal configuration can not be reached easily, for the MOVE_TO_CART_GOAL, waiting for the other approach");
+		finish(*race, race->cartesian, false);
+		return;
+	}
+	if (aborted(*race))
+	{
+		finish(*race, race->cartesian, false);
+		return;
+	}
+
+	ROS_INFO("Sucessfully found a good goal position for the MOVE_TO_CART_GOAL");
+
+	const trajectory_msgs::JointTrajectoryPoint &goal_point = moveit_trajectory.joint_trajectory.points.back();
+
+	// build the joint constraint out of the goal point
+	moveit_msgs::Constraints goal_state;
+	moveit_msgs::JointConstraint joint_constraint;
+	for (int i=0; i<goal_point.positions.size(); i++ )
+	{
+		joint_constraint.joint_name = moveit_trajectory.joint_trajectory.joint_names[i];
+		joint_constraint.position = goal_point.positions[i];
+		joint_constraint.weight = 1.0;
+		// tolerances of 0.0 above and below are the default anyway
+		// joint_constraint.tolerance_above = 0.0;
+		// joint_constraint.tolerance_below = 0.0;
+		goal_state.joint_constraints.push_back(joint_constraint);
+	}
+
+	definitions::TrajectoryPlanning::Response response;
+	bool success = planTrajectory(response.trajectory, goal_state, *req) && response.trajectory.size() > 0;
+	response.result = success ? response.SUCCESS : response.NO_FEASIBLE_TRAJECTORY_FOUND;
+
+	race->cartesian.response = response;
+	finish(*race, race->cartesian, success);
+}
+
+double CartPlanner::searchCartesianPath(const Request &req, Race &race, moveit_msgs::RobotTrajectory &trajectory)
+{
+	// the candidates are the thresholds a serial search growing jump_threshold_ would try, in increasing order
+	std::vector<double> thresholds;
+	for (double t = jump_threshold_; t < max_jump_threshold_; t *= jump_threshold_factor_)
+		thresholds.push_back(t);
+
+	// the candidates are tried in increasing order, up to search_width_ of them at once, and the smallest
+	// one covering the whole path is taken, so a working jump_threshold_, the usual case, costs one round
+	double best = 0.0;
+	for (int lo = 0; lo < (int)thresholds.size() && !aborted(race);)
+	{
+		const int n = std::min(std::max(search_width_, 1), (int)thresholds.size() - lo);
+		std::vector<double> fractions(n, 0.0);
+		std::vector<moveit_msgs::RobotTrajectory> paths(n);
+
+		boost::thread_group group;
+		for (int i = 0; i < n; ++i)
+			group.create_thread(boost::bind(&CartPlanner::computeCartesianPath, this, boost::cref(req), thresholds[lo + i], boost::ref(paths[i]), boost::ref(fractions[i])));
+		group.join_all();
+
+		for (int i = 0; i < n; ++i)
+		{
+			if (fractions[i] < 1.0)
+				continue;
+			trajectory = paths[i];
+			ROS_INFO("The whole path could be computed with jump threshold %f", thresholds[lo + i]);
+			return fractions[i];
+		}
+
+		// as the serial search, report the largest threshold tried
+		best = fractions[n - 1];
+		lo += n;
+		ROS_INFO("Only %f part of the path could be computed with jump threshold %f", best, thresholds[lo - 1]);
+	}
+
+	return best;
+}
+
+void CartPlanner::computeCartesianPath(const Request &req, double jump_threshold, moveit_msgs::RobotTrajectory &trajectory, double &fraction)
+{
+	moveit_msgs::GetCartesianPath cartesian_path;
+	moveit_msgs::GetCartesianPath::Request &path_request = cartesian_path.request;
+
+	path_request.header.frame_id = req.pose_frame;
+	path_request.header.stamp = ros::Time::now();
+	path_request.start_state.joint_state = req.start_state;
+	path_request.group_name = req.group_name;
+	path_request.link_name = req.eef_link;
+	path_request.waypoints.push_back(req.goal_hand.wrist_pose.pose);
+	path_request.max_step = eef_step_;
+	path_request.jump_threshold = jump_threshold;
+	path_request.avoid_collisions = true;
+
+	fraction = 0.0;
+	ros::ServiceClient client = nh_.serviceClient<moveit_msgs::GetCartesianPath>(cartesian_service_name_);
+	if (!client.call(cartesian_path))
+	{
+		ROS_WARN("Cartesian path service call failed");
+		return;
+	}
+	if (cartesian_path.response.error_code.val != moveit_msgs::MoveItErrorCodes::SUCCESS)
+		return;
+
+	fraction = cartesian_path.response.fraction;
+	trajectory = cartesian_path.response.solution;
+}
+
 void CartPlanner::callback_collision_object(const moveit_msgs::AttachedCollisionObject &object)
 {
   collision_objects_.clear();
   collision_objects_.push_back(object);   
 }
 
-bool CartPlanner::planTrajectory(std::vector<definitions::Trajectory> &trajectories, moveit_msgs::Constraints &goal, std::string &arm, sensor_msgs::JointState &startState, definitions::SDHand &goal_hand) 
+bool CartPlanner::planTrajectory(std::vector<definitions::Trajectory> &trajectories, moveit_msgs::Constraints &goal, const Request &req) 
 {
+	const std::string &arm = req.arm;
+	const sensor_msgs::JointState &startState = req.start_state;
+	const definitions::SDHand &goal_hand = req.goal_hand;
+
 	ROS_INFO("USING CARLOS' CONFIGURATION FOR CARTESIAN PLANNING");
 
 	// now construct the motion plan request
@@ -193,7 +313,7 @@ bool CartPlanner::planTrajectory(std::vector<definitions::Trajectory> &trajector
 	moveit_msgs::MotionPlanRequest &motion_plan_request = motion_plan.request.motion_plan_request;
 
 	// constraint for the wrist
-	motion_plan_request.group_name = group_name_.c_str();
+	motion_plan_request.group_name = req.group_name;
 	motion_plan_request.goal_constraints.push_back(goal);
 	//motion_plan_request.goal_constraints[0].joint_constraints = handJointsGoal;
 
@@ -203,14 +323,14 @@ bool CartPlanner::planTrajectory(std::vector<definitions::Trajectory> &trajector
 
 	moveit_msgs::RobotState start_state;
 	start_state.joint_state = startState;
-	start_state.attached_collision_objects = collision_objects_;
-	collision_objects_.clear();
+	start_state.attached_collision_objects = req.collision_objects;
 	motion_plan_request.start_state = start_state;
 
 
 	// and call the service with the request
 	ROS_INFO("Calling plannig service...");
-	bool success = clt_moveit_planning_.call(motion_plan);
+	ros::ServiceClient client = nh_.serviceClient<moveit_msgs::GetMotionPlan>(planning_service_name_);
+	bool success = client.call(motion_plan);
 
 	// check results 
 	if(success) 
@@ -235,19 +355,24 @@ bool CartPlanner::planTrajectory(std::vector<definitions::Trajectory> &trajector
 
 			moveit_msgs::RobotTrajectory robot_trajectory = motion_plan.response.motion_plan_response.trajectory;
 
-			// fill the robot trajectory with hand values, given the base trajectory of the arm
 			if( trajSize <= min_traj_size_ )
-			{
 				ROS_WARN("Trajectory size is less than the minimium.");
-				pacman::interpolateHandJoints(goal_hand, startState, robot_trajectory, arm, false);
+
+			// fill the robot trajectory with hand values, given the base trajectory of the arm
+			// populate trajectory with motion plan data
+			// the start state is used to copy the data for the joints that are not being used in the planning
+			// the joints of the start state are found by name once for both conversions, and a state without them can not be converted
+			try
+			{
+				pacman::JointStateMap map;
+				pacman::interpolateHandJoints(goal_hand, startState, robot_trajectory, arm, map, trajSize > min_traj_size_);
+				pacman::convertLimb(robot_trajectory, trajectory, startState, arm, map);
 			}
-			else
+			catch (const std::runtime_error &e)
 			{
-				pacman::interpolateHandJoints(goal_hand, startState, robot_trajectory, arm);			
+				ROS_ERROR("%s", e.what());
+				return false;
 			}
-			// populate trajectory with motion plan data
-			// the start state is used to copy the data for the joints that are not being used in the planning
-			pacman::convertLimb(robot_trajectory, trajectory, startState, arm);
 
 			trajectories.push_back(trajectory);
 
@@ -261,8 +386,12 @@ bool CartPlanner::planTrajectory(std::vector<definitions::Trajectory> &trajector
 	}
 }
 
-bool CartPlanner::planTrajectoryUIBK(std::vector<definitions::Trajectory> &trajectories, definitions::SDHand &goal, std::string &arm, sensor_msgs::JointState &startState, definitions::TrajectoryPlanning::Response &response)
+bool CartPlanner::planTrajectoryUIBK(std::vector<definitions::Trajectory> &trajectories, const Request &req, Race &race, definitions::TrajectoryPlanning::Response &response)
 {
+	const std::string &arm = req.arm;
+	const sensor_msgs::JointState &startState = req.start_state;
+	const definitions::SDHand &goal = req.goal_hand;
+
 	ROS_INFO("USING MARTIN's CONFIGURATION FOR CARTESIAN PLANNING");
 	ROS_INFO("Planning for wrist (px, py, pz, qx, qy, qz, qw):\t%f\t%f\t%f\t%f\t%f\t%f\t%f", goal.wrist_pose.pose.position.x, goal.wrist_pose.pose.position.y, goal.wrist_pose.pose.position.z, goal.wrist_pose.pose.orientation.x, goal.wrist_pose.pose.orientation.y, goal.wrist_pose.pose.orientation.z, goal.wrist_pose.pose.orientation.w);
 
@@ -278,11 +407,19 @@ bool CartPlanner::planTrajectoryUIBK(std::vector<definitions::Trajectory> &traje
 
 	// compute a set of ik solutions and construct goal constraint
 	for (int i = 0; i < 5; ++i) {
+		if (aborted(race))
+			return false;
+
 		moveit_msgs::RobotState ik_solution;
 
 		geometry_msgs::PoseStamped pose_goal = goal.wrist_pose;
 
-		if(ki_helper_.computeIK(arm, pose_goal, startState, ik_solution, plan_for_frame_)) {
+		bool found;
+		{
+			boost::mutex::scoped_lock lock(ki_mutex_);
+			found = ki_helper_.computeIK(arm, pose_goal, startState, ik_solution, req.plan_for_frame);
+		}
+		if(found) {
 			vector<double> values;
 			getJointPositionsFromState(joint_names, ik_solution, values);
 
@@ -308,7 +445,7 @@ bool CartPlanner::planTrajectoryUIBK(std::vector<definitions::Trajectory> &traje
 	}
 
 	// constraint for the wrist
-	motion_plan_request.group_name = group_name_.c_str();
+	motion_plan_request.group_name = req.group_name;
 
 	//motion_plan_request.goal_constraints[0].joint_constraints = handJointsGoal;
 
@@ -318,14 +455,17 @@ bool CartPlanner::planTrajectoryUIBK(std::vector<definitions::Trajectory> &traje
 
 	moveit_msgs::RobotState start_state;
 	start_state.joint_state = startState;
-	start_state.attached_collision_objects = collision_objects_;
-	collision_objects_.clear();
+	start_state.attached_collision_objects = req.collision_objects;
 	motion_plan_request.start_state = start_state;
 
+	// the other attempt may have answered the request during the ik
+	if (aborted(race))
+		return false;
 
 	// and call the service with the request
 	ROS_INFO("Calling plannig service...");
-	bool success = clt_moveit_planning_.call(motion_plan);
+	ros::ServiceClient client = nh_.serviceClient<moveit_msgs::GetMotionPlan>(planning_service_name_);
+	bool success = client.call(motion_plan);
 
 	// check results 
 	if(success) 
@@ -352,14 +492,20 @@ bool CartPlanner::planTrajectoryUIBK(std::vector<definitions::Trajectory> &traje
 			moveit_msgs::RobotTrajectory robot_trajectory = motion_plan.response.motion_plan_response.trajectory;
 
 			// fill the robot trajectory with hand values, given the base trajectory of the arm
-			//pacman::interpolateHandJoints(goal, startState, robot_trajectory, arm);	
-			if( trajSize <= min_traj_size_ )
-			  pacman::interpolateHandJoints(goal, startState, robot_trajectory, arm,false);
-            else
-              pacman::interpolateHandJoints(goal, startState, robot_trajectory, arm);					
 			// populate trajectory with motion plan data
 			// the start state is used to copy the data for the joints that are not being used in the planning
-			pacman::convertLimb(robot_trajectory, trajectory, startState, arm);
+			// the joints of the start state are found by name once for both conversions, and a state without them can not be converted
+			try
+			{
+				pacman::JointStateMap map;
+				pacman::interpolateHandJoints(goal, startState, robot_trajectory, arm, map, trajSize > min_traj_size_);
+				pacman::convertLimb(robot_trajectory, trajectory, startState, arm, map);
+			}
+			catch (const std::runtime_error &e)
+			{
+				ROS_ERROR("%s", e.what());
+				return false;
+			}
 
 			trajectories.push_back(trajectory);
 
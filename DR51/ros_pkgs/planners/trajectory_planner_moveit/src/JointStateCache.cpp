@@ -0,0 +1,78 @@
+//// system headers
+#include <boost/bind.hpp>
+
+//// ros headers
+
+//// local headers
+#include <JointStateCache.h>
+
+
+namespace trajectory_planner_moveit {
+
+
+JointStateCache::JointStateCache(ros::NodeHandle &nh, const std::string &topic, const ros::Duration &max_age) : max_age_(max_age)
+{
+	topic_ = nh.resolveName(topic);
+
+	// a private queue, so the cache is not served by the main spin loop
+	ros::SubscribeOptions options = ros::SubscribeOptions::create<sensor_msgs::JointState>(topic_, 1, boost::bind(&JointStateCache::callback_joint_states, this, _1), ros::VoidPtr(), &queue_);
+	options.transport_hints = ros::TransportHints().tcpNoDelay();
+	sub_joint_states_ = nh.subscribe(options);
+
+	spinner_.reset(new ros::AsyncSpinner(1, &queue_));
+	spinner_->start();
+}
+
+JointStateCache::~JointStateCache()
+{
+	spinner_->stop();
+	sub_joint_states_.shutdown();
+}
+
+void JointStateCache::callback_joint_states(const sensor_msgs::JointStateConstPtr &state)
+{
+	boost::shared_ptr<Sample> sample(new Sample);
+	sample->state = state;
+	sample->received = ros::Time::now();
+
+	boost::atomic_store(&sample_, boost::shared_ptr<const Sample>(sample));
+}
+
+sensor_msgs::JointStateConstPtr JointStateCache::get() const
+{
+	boost::shared_ptr<const Sample> sample = boost::atomic_load(&sample_);
+
+	if (!sample || ros::Time::now() - sample->received > max_age_)
+		return sensor_msgs::JointStateConstPtr();
+
+	return sample->state;
+}
+
+sensor_msgs::JointStateConstPtr JointStateCache::get(const ros::Duration &timeout) const
+{
+	sensor_msgs::JointStateConstPtr state = get();
+	if (state)
+		return state;
+
+	ROS_DEBUG_NAMED("JointStateCache", "No fresh joint state in topic %s, waiting...", topic_.c_str());
+
+	const ros::Time deadline = ros::Time::now() + timeout;
+	ros::WallDuration poll(0.001);
+	while (!state && ros::ok() && ros::Time::now() < deadline)
+	{
+		poll.sleep();
+		state = get();
+	}
+
+	return state;
+}
+
+ros::Duration JointStateCache::age() const
+{
+	boost::shared_ptr<const Sample> sample = boost::atomic_load(&sample_);
+
+	return sample ? ros::Time::now() - sample->received : ros::Duration(-1.0);
+}
+
+
+}
@@ -34,11 +34,11 @@ bool PickPlanner::planTrajectoryFromCode(definitions::TrajectoryPlanning::Reques
 		// this is were the response will be filled
 		std::vector<definitions::Trajectory> &trajectories = response.trajectory;
 
-		// wait for a joint state to read the current state
-		boost::shared_ptr<const sensor_msgs::JointState> current_state_ptr = ros::topic::waitForMessage<sensor_msgs::JointState>(topic_, ros::Duration(3.0));
+		// read the current state, only waits if the cached one is stale
+		sensor_msgs::JointStateConstPtr current_state_ptr = joint_states_->get(ros::Duration(3.0));
 		if (!current_state_ptr)
 		{
-			ROS_ERROR("No real start state available, since no joint state recevied in topic: %s", topic_.c_str());
+			ROS_ERROR("No real start state available, since no joint state recevied in topic: %s", joint_states_->topic_.c_str());
 			ROS_ERROR("Did you forget to start a controller?");
 			response.result = response.OTHER_ERROR;
 			return false;
@@ -387,7 +387,16 @@ bool PickPlanner::planTrajectoryFromCode(definitions::TrajectoryPlanning::Reques
 			
 			// populate trajectory with motion plan data
 			// the start state is used to copy the data for the joints that are not being used in the planning			
-			pacman::convertLimb(robot_trajectory, trajectory, start_state.joint_state, request.arm);
+			try
+			{
+				pacman::convertLimb(robot_trajectory, trajectory, start_state.joint_state, request.arm);
+			}
+			catch (const std::runtime_error &e)
+			{
+				ROS_ERROR("%s", e.what());
+				response.result = response.OTHER_ERROR;
+				return false;
+			}
 
 			trajectories.push_back(trajectory);
 
@@ -28,11 +28,11 @@ bool StatePlanner::planTrajectoryFromCode(definitions::TrajectoryPlanning::Reque
 		// clear all previously cached motion plans
 		std::vector<definitions::Trajectory> &trajectories = response.trajectory;
 
-		// wait for a joint state
-		boost::shared_ptr<const sensor_msgs::JointState> current_state_ptr = ros::topic::waitForMessage<sensor_msgs::JointState>(topic_, ros::Duration(3.0));
+		// read the current state, only waits if the cached one is stale
+		sensor_msgs::JointStateConstPtr current_state_ptr = joint_states_->get(ros::Duration(3.0));
 		if (!current_state_ptr)
 		{
-			ROS_WARN("No real start state available, since no joint state recevied in topic: %s", topic_.c_str());
+			ROS_WARN("No real start state available, since no joint state recevied in topic: %s", joint_states_->topic_.c_str());
 			ROS_WARN("Did you forget to start a controller?");
 			ROS_WARN("Planning will be done from home position, however this trajectory might not be good for execution!");
 		}
@@ -142,13 +142,20 @@ bool StatePlanner::planTrajectory(std::vector<definitions::Trajectory> &trajecto
 				my_hand = goal.handLeft;
 
 			// fill the robot trajectory with hand values, given the base trajectory of the arm
-			if( trajSize <= min_traj_size_ )
-			  pacman::interpolateHandJoints(my_hand, startState, robot_trajectory, arm,false);
-            else
-              pacman::interpolateHandJoints(my_hand, startState, robot_trajectory, arm);
 			// populate trajectory with motion plan data
 			// the start state is used to copy the data for the joints that are not being used in the planning
-			pacman::convertLimb(robot_trajectory, trajectory, startState, arm);
+			// the joints of the start state are found by name once for both conversions, and a state without them can not be converted
+			try
+			{
+				pacman::JointStateMap map;
+				pacman::interpolateHandJoints(my_hand, startState, robot_trajectory, arm, map, trajSize > min_traj_size_);
+				pacman::convertLimb(robot_trajectory, trajectory, startState, arm, map);
+			}
+			catch (const std::runtime_error &e)
+			{
+				ROS_ERROR("%s", e.what());
+				return false;
+			}
 
 			trajectories.push_back(trajectory);
 
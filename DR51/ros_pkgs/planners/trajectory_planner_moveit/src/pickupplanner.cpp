@@ -14,7 +14,7 @@
 namespace trajectory_planner_moveit {
 
 
-PickupPlanner::PickupPlanner(ros::NodeHandle &nh)
+PickupPlanner::PickupPlanner(ros::NodeHandle &nh, JointStateCachePtr joint_states) : joint_states_(joint_states)
 {
     // set some default values...
     planning_time_ = 5.0;
@@ -28,8 +28,6 @@ PickupPlanner::PickupPlanner(ros::NodeHandle &nh)
     string pickup_topic = "pickup";
     pick_action_client_.reset(new actionlib::SimpleActionClient<moveit_msgs::PickupAction>(pickup_topic, true));
     pick_action_client_->waitForServer();
-    // retrieve the (remapped) joint states topic name
-    joint_states_topic_ = nh.resolveName("/joint_states");
 
 }
 
@@ -264,12 +262,12 @@ bool PickupPlanner::PickupResultToTrajectory(const string &arm,
                                              moveit_msgs::PickupResultConstPtr &result,
                                              definitions::Trajectory &trajectory)
 {
-    // wait for a joint state message to retrieve the current configuration of the robot
-    sensor_msgs::JointStateConstPtr start_state = ros::topic::waitForMessage<sensor_msgs::JointState>(joint_states_topic_, ros::Duration(3.0));
+    // the cached joint state is the current configuration of the robot, only waits if it is stale
+    sensor_msgs::JointStateConstPtr start_state = joint_states_->get(ros::Duration(3.0));
 
     if (!start_state)
     {
-        ROS_WARN("No real start state available, since no joint state recevied in topic: %s", joint_states_topic_.c_str());
+        ROS_WARN("No real start state available, since no joint state recevied in topic: %s", joint_states_->topic_.c_str());
         ROS_WARN("Did you forget to start a controller?");
         ROS_WARN("The resulting trajectory might be invalid!");
 
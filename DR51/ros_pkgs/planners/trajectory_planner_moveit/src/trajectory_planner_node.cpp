@@ -16,6 +16,7 @@
 #include "StatePlanner.h"
 // #include "pickupplanner.h"
 #include "PickPlanner.h"
+#include "JointStateCache.h"
 
 
 namespace trajectory_planner_moveit {
@@ -34,6 +35,9 @@ class TrajPlanner
     // services
     ros::ServiceServer srv_trajectory_planning_;
 
+    // the latest joint state, shared by all planners
+    trajectory_planner_moveit::JointStateCachePtr joint_states_;
+
     // the trajectory planner helper class
     trajectory_planner_moveit::CartPlanner *my_cart_planner_;
     trajectory_planner_moveit::StatePlanner *my_state_planner_;
@@ -56,15 +60,21 @@ class TrajPlanner
 	   srv_trajectory_planning_ = nh_.advertiseService(nh_.resolveName("/trajectory_planning_srv"),&TrajPlanner::planTrajectory, this);
 	   
        // init class members
-       my_cart_planner_ = new trajectory_planner_moveit::CartPlanner(nh_);
-       my_state_planner_ = new trajectory_planner_moveit::StatePlanner(nh_);
-       my_pick_planner_ = new trajectory_planner_moveit::PickPlanner(nh_);
-//        pickup_planner_.reset(new PickupPlanner(nh));
+       joint_states_.reset(new trajectory_planner_moveit::JointStateCache(nh_));
+       my_cart_planner_ = new trajectory_planner_moveit::CartPlanner(nh_, joint_states_);
+       my_state_planner_ = new trajectory_planner_moveit::StatePlanner(nh_, joint_states_);
+       my_pick_planner_ = new trajectory_planner_moveit::PickPlanner(nh_, joint_states_);
+//        pickup_planner_.reset(new PickupPlanner(nh, joint_states_));
        
     }
 
-    //! Empty stub
-    ~TrajPlanner() {}
+    // the cartesian planner joins its remaining planning attempts
+    ~TrajPlanner()
+    {
+       delete my_cart_planner_;
+       delete my_state_planner_;
+       delete my_pick_planner_;
+    }
 
 };
 
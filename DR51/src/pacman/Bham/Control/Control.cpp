@@ -7,7 +7,16 @@ using namespace golem;
 
 //-----------------------------------------------------------------------------
 
-BhamControlImpl::BhamControlImpl(golem::Controller& controller) : controller(controller), context(controller.getContext()), info(controller.getStateInfo()) {}
+BhamControlImpl::BhamControlImpl(golem::Controller& controller) : controller(controller), context(controller.getContext()), info(controller.getStateInfo()) {
+	// unknown configurations are reported by convert()
+	robotType =
+		matchConfig<RobotUIBK::Config::CHAINS, 7 + 3 + 3 + 2>(info) ? Robot::Type::ROBOT_UIBK :
+		matchConfig<RobotEddie::Config::CHAINS, 2*(7 + 3 + 3 + 2) + 7>(info) ? Robot::Type::ROBOT_EDDIE :
+		Robot::Type(0);
+
+	for (Chainspace::Index i = info.getChains().begin(); i < info.getChains().end(); ++i)
+		chainJoints.push_back(info.getJoints(i).begin());
+}
 
 pacman::float_t BhamControlImpl::time() const {
 	return context.getTimer().elapsed();
@@ -18,13 +27,13 @@ pacman::float_t BhamControlImpl::cycleDuration() const {
 }
 
 void BhamControlImpl::lookupState(pacman::float_t t, Robot::State& state) const {
-	Controller::State inp = controller.createState();
+	Controller::State& inp = *getStates(1);
 	controller.lookupState((SecTmReal)t, inp);
 	convert(inp, state);
 }
 
 void BhamControlImpl::lookupCommand(pacman::float_t t, Robot::Command& command) const {
-	Controller::State inp = controller.createState();
+	Controller::State& inp = *getStates(1);
 	controller.lookupCommand((SecTmReal)t, inp);
 	convert(inp, command);
 }
@@ -33,13 +42,13 @@ void BhamControlImpl::send(const Robot::Command* command, std::uintptr_t size) {
 	if (size <= 0)
 		throw Message(Message::LEVEL_ERROR, "BhamControlImpl::send(): invalid number of commands %u", size);
 	
-	Controller::State::Seq seq(size, controller.createState());
-	for (Controller::State::Seq::iterator i = seq.begin(); i != seq.end(); ++i) {
+	Controller::State* seq = getStates(size);
+	for (Controller::State* i = seq; i < seq + size; ++i) {
 		controller.setToDefault(*i);
-		convert((const Robot::Command&)(*command)(i - seq.begin()), *i);
+		convert((const Robot::Command&)(*command)(i - seq), *i);
 	}
 
-	controller.send(seq.data(), seq.data() + size);
+	controller.send(seq, seq + size);
 }
 
 bool BhamControlImpl::waitForCycleBegin(double timewait) {
@@ -60,16 +69,28 @@ void BhamControlImpl::assertRobotEddie() const {
 	assertConfig<RobotEddie::Config::CHAINS, 2*(7 + 3 + 3 + 2) + 7>(controller.getStateInfo());
 }
 
+Controller::State* BhamControlImpl::getStates(std::uintptr_t size) const {
+	Controller::State::Seq* seq = states.get();
+	if (seq == nullptr)
+		states.reset(seq = new Controller::State::Seq());
+	// allocates only on the first call of a thread, or for a longer command sequence
+	if (seq->size() < size)
+		seq->resize(size, controller.createState());
+	return seq->data();
+}
+
 //-----------------------------------------------------------------------------
 
 void BhamControlImpl::convert(const ::golem::Controller::State& src, Robot::State& dst) const {
 	switch (dst.getType()) {
 	case Robot::Type::ROBOT_UIBK:
-		BhamControlImpl::assertRobotUIBK(); // throws
+		if (robotType != Robot::Type::ROBOT_UIBK)
+			BhamControlImpl::assertRobotUIBK(); // throws
 		convert(src, (RobotUIBK::State&)dst);
 		break;
 	case Robot::Type::ROBOT_EDDIE:
-		BhamControlImpl::assertRobotEddie(); // throws
+		if (robotType != Robot::Type::ROBOT_EDDIE)
+			BhamControlImpl::assertRobotEddie(); // throws
 		convert(src, (RobotEddie::State&)dst);
 		break;
 	default:
@@ -80,11 +101,13 @@ void BhamControlImpl::convert(const ::golem::Controller::State& src, Robot::Stat
 void BhamControlImpl::convert(const ::golem::Controller::State& src, Robot::Command& dst) const {
 	switch (dst.getType()) {
 	case Robot::Type::ROBOT_UIBK:
-		BhamControlImpl::assertRobotUIBK(); // throws
+		if (robotType != Robot::Type::ROBOT_UIBK)
+			BhamControlImpl::assertRobotUIBK(); // throws
 		convert(src, (RobotUIBK::Command&)dst);
 		break;
 	case Robot::Type::ROBOT_EDDIE:
-		BhamControlImpl::assertRobotEddie(); // throws
+		if (robotType != Robot::Type::ROBOT_EDDIE)
+			BhamControlImpl::assertRobotEddie(); // throws
 		convert(src, (RobotEddie::Command&)dst);
 		break;
 	default:
@@ -95,11 +118,13 @@ void BhamControlImpl::convert(const ::golem::Controller::State& src, Robot::Comm
 void BhamControlImpl::convert(const Robot::Command& src, ::golem::Controller::State& dst) const {
 	switch (src.getType()) {
 	case Robot::Type::ROBOT_UIBK:
-		BhamControlImpl::assertRobotUIBK(); // throws
+		if (robotType != Robot::Type::ROBOT_UIBK)
+			BhamControlImpl::assertRobotUIBK(); // throws
 		convert((const RobotUIBK::Command&)src, dst);
 		break;
 	case Robot::Type::ROBOT_EDDIE:
-		BhamControlImpl::assertRobotEddie(); // throws
+		if (robotType != Robot::Type::ROBOT_EDDIE)
+			BhamControlImpl::assertRobotEddie(); // throws
 		convert((const RobotEddie::Command&)src, dst);
 		break;
 	default:
@@ -113,35 +138,35 @@ void BhamControlImpl::convert(const ::golem::Controller::State& src, RobotUIBK::
 	// time
 	dst.t = (pacman::float_t)src.t;
 	// arm
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 0).begin()], dst.arm.pos);
+	configToPacman(&src.cpos[chainJoints[0]], dst.arm.pos);
 	// hand
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 1).begin()], dst.hand.pos);
+	configToPacman(&src.cpos[chainJoints[1]], dst.hand.pos);
 }
 
 void BhamControlImpl::convert(const ::golem::Controller::State& src, RobotUIBK::Command& dst) const {
 	// time
 	dst.t = (pacman::float_t)src.t;
 	// arm
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 0).begin()], dst.arm.pos);
-	configToPacman(&src.cvel[info.getJoints(info.getChains().begin() + 0).begin()], dst.arm.vel);
-	configToPacman(&src.cacc[info.getJoints(info.getChains().begin() + 0).begin()], dst.arm.acc);
+	configToPacman(&src.cpos[chainJoints[0]], dst.arm.pos);
+	configToPacman(&src.cvel[chainJoints[0]], dst.arm.vel);
+	configToPacman(&src.cacc[chainJoints[0]], dst.arm.acc);
 	// hand
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 1).begin()], dst.hand.pos);
-	configToPacman(&src.cvel[info.getJoints(info.getChains().begin() + 1).begin()], dst.hand.vel);
-	configToPacman(&src.cacc[info.getJoints(info.getChains().begin() + 1).begin()], dst.hand.acc);
+	configToPacman(&src.cpos[chainJoints[1]], dst.hand.pos);
+	configToPacman(&src.cvel[chainJoints[1]], dst.hand.vel);
+	configToPacman(&src.cacc[chainJoints[1]], dst.hand.acc);
 }
 
 void BhamControlImpl::convert(const RobotUIBK::Command& src, ::golem::Controller::State& dst) const {
 	// time
 	dst.t = (SecTmReal)src.t;
 	// arm
-	configToGolem(src.arm.pos, &dst.cpos[info.getJoints(info.getChains().begin() + 0).begin()]);
-	configToGolem(src.arm.vel, &dst.cvel[info.getJoints(info.getChains().begin() + 0).begin()]);
-	configToGolem(src.arm.acc, &dst.cacc[info.getJoints(info.getChains().begin() + 0).begin()]);
+	configToGolem(src.arm.pos, &dst.cpos[chainJoints[0]]);
+	configToGolem(src.arm.vel, &dst.cvel[chainJoints[0]]);
+	configToGolem(src.arm.acc, &dst.cacc[chainJoints[0]]);
 	// hand
-	configToGolem(src.hand.pos, &dst.cpos[info.getJoints(info.getChains().begin() + 1).begin()]);
-	configToGolem(src.hand.vel, &dst.cvel[info.getJoints(info.getChains().begin() + 1).begin()]);
-	configToGolem(src.hand.acc, &dst.cacc[info.getJoints(info.getChains().begin() + 1).begin()]);
+	configToGolem(src.hand.pos, &dst.cpos[chainJoints[1]]);
+	configToGolem(src.hand.vel, &dst.cvel[chainJoints[1]]);
+	configToGolem(src.hand.acc, &dst.cacc[chainJoints[1]]);
 }
 
 //-----------------------------------------------------------------------------
@@ -150,65 +175,65 @@ void BhamControlImpl::convert(const ::golem::Controller::State& src, RobotEddie:
 	// time
 	dst.t = (pacman::float_t)src.t;
 	// arm
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 0).begin()], dst.armLeft.pos);
+	configToPacman(&src.cpos[chainJoints[0]], dst.armLeft.pos);
 	// hand
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 1).begin()], dst.handLeft.pos);
+	configToPacman(&src.cpos[chainJoints[1]], dst.handLeft.pos);
 	// arm
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 4).begin()], dst.armRight.pos);
+	configToPacman(&src.cpos[chainJoints[4]], dst.armRight.pos);
 	// hand
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 5).begin()], dst.handRight.pos);
+	configToPacman(&src.cpos[chainJoints[5]], dst.handRight.pos);
 	// head
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 8).begin()], dst.head.pos);
+	configToPacman(&src.cpos[chainJoints[8]], dst.head.pos);
 }
 
 void BhamControlImpl::convert(const ::golem::Controller::State& src, RobotEddie::Command& dst) const {
 	// time
 	dst.t = (pacman::float_t)src.t;
 	// arm
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 0).begin()], dst.armLeft.pos);
-	configToPacman(&src.cvel[info.getJoints(info.getChains().begin() + 0).begin()], dst.armLeft.vel);
-	configToPacman(&src.cacc[info.getJoints(info.getChains().begin() + 0).begin()], dst.armLeft.acc);
+	configToPacman(&src.cpos[chainJoints[0]], dst.armLeft.pos);
+	configToPacman(&src.cvel[chainJoints[0]], dst.armLeft.vel);
+	configToPacman(&src.cacc[chainJoints[0]], dst.armLeft.acc);
 	// hand
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 1).begin()], dst.handLeft.pos);
-	configToPacman(&src.cvel[info.getJoints(info.getChains().begin() + 1).begin()], dst.handLeft.vel);
-	configToPacman(&src.cacc[info.getJoints(info.getChains().begin() + 1).begin()], dst.handLeft.acc);
+	configToPacman(&src.cpos[chainJoints[1]], dst.handLeft.pos);
+	configToPacman(&src.cvel[chainJoints[1]], dst.handLeft.vel);
+	configToPacman(&src.cacc[chainJoints[1]], dst.handLeft.acc);
 	// arm
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 4).begin()], dst.armRight.pos);
-	configToPacman(&src.cvel[info.getJoints(info.getChains().begin() + 4).begin()], dst.armRight.vel);
-	configToPacman(&src.cacc[info.getJoints(info.getChains().begin() + 4).begin()], dst.armRight.acc);
+	configToPacman(&src.cpos[chainJoints[4]], dst.armRight.pos);
+	configToPacman(&src.cvel[chainJoints[4]], dst.armRight.vel);
+	configToPacman(&src.cacc[chainJoints[4]], dst.armRight.acc);
 	// hand
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 5).begin()], dst.handRight.pos);
-	configToPacman(&src.cvel[info.getJoints(info.getChains().begin() + 5).begin()], dst.handRight.vel);
-	configToPacman(&src.cacc[info.getJoints(info.getChains().begin() + 5).begin()], dst.handRight.acc);
+	configToPacman(&src.cpos[chainJoints[5]], dst.handRight.pos);
+	configToPacman(&src.cvel[chainJoints[5]], dst.handRight.vel);
+	configToPacman(&src.cacc[chainJoints[5]], dst.handRight.acc);
 	// head
-	configToPacman(&src.cpos[info.getJoints(info.getChains().begin() + 8).begin()], dst.head.pos);
-	configToPacman(&src.cvel[info.getJoints(info.getChains().begin() + 8).begin()], dst.head.vel);
-	configToPacman(&src.cacc[info.getJoints(info.getChains().begin() + 8).begin()], dst.head.acc);
+	configToPacman(&src.cpos[chainJoints[8]], dst.head.pos);
+	configToPacman(&src.cvel[chainJoints[8]], dst.head.vel);
+	configToPacman(&src.cacc[chainJoints[8]], dst.head.acc);
 }
 
 void BhamControlImpl::convert(const RobotEddie::Command& src, ::golem::Controller::State& dst) const {
 	// time
 	dst.t = (SecTmReal)src.t;
 	// arm
-	configToGolem(src.armLeft.pos, &dst.cpos[info.getJoints(info.getChains().begin() + 0).begin()]);
-	configToGolem(src.armLeft.vel, &dst.cvel[info.getJoints(info.getChains().begin() + 0).begin()]);
-	configToGolem(src.armLeft.acc, &dst.cacc[info.getJoints(info.getChains().begin() + 0).begin()]);
+	configToGolem(src.armLeft.pos, &dst.cpos[chainJoints[0]]);
+	configToGolem(src.armLeft.vel, &dst.cvel[chainJoints[0]]);
+	configToGolem(src.armLeft.acc, &dst.cacc[chainJoints[0]]);
 	// hand
-	configToGolem(src.handLeft.pos, &dst.cpos[info.getJoints(info.getChains().begin() + 1).begin()]);
-	configToGolem(src.handLeft.vel, &dst.cvel[info.getJoints(info.getChains().begin() + 1).begin()]);
-	configToGolem(src.handLeft.acc, &dst.cacc[info.getJoints(info.getChains().begin() + 1).begin()]);
+	configToGolem(src.handLeft.pos, &dst.cpos[chainJoints[1]]);
+	configToGolem(src.handLeft.vel, &dst.cvel[chainJoints[1]]);
+	configToGolem(src.handLeft.acc, &dst.cacc[chainJoints[1]]);
 	// arm
-	configToGolem(src.armRight.pos, &dst.cpos[info.getJoints(info.getChains().begin() + 4).begin()]);
-	configToGolem(src.armRight.vel, &dst.cvel[info.getJoints(info.getChains().begin() + 4).begin()]);
-	configToGolem(src.armRight.acc, &dst.cacc[info.getJoints(info.getChains().begin() + 4).begin()]);
+	configToGolem(src.armRight.pos, &dst.cpos[chainJoints[4]]);
+	configToGolem(src.armRight.vel, &dst.cvel[chainJoints[4]]);
+	configToGolem(src.armRight.acc, &dst.cacc[chainJoints[4]]);
 	// hand
-	configToGolem(src.handRight.pos, &dst.cpos[info.getJoints(info.getChains().begin() + 5).begin()]);
-	configToGolem(src.handRight.vel, &dst.cvel[info.getJoints(info.getChains().begin() + 5).begin()]);
-	configToGolem(src.handRight.acc, &dst.cacc[info.getJoints(info.getChains().begin() + 5).begin()]);
+	configToGolem(src.handRight.pos, &dst.cpos[chainJoints[5]]);
+	configToGolem(src.handRight.vel, &dst.cvel[chainJoints[5]]);
+	configToGolem(src.handRight.acc, &dst.cacc[chainJoints[5]]);
 	// head
-	configToGolem(src.head.pos, &dst.cpos[info.getJoints(info.getChains().begin() + 8).begin()]);
-	configToGolem(src.head.vel, &dst.cvel[info.getJoints(info.getChains().begin() + 8).begin()]);
-	configToGolem(src.head.acc, &dst.cacc[info.getJoints(info.getChains().begin() + 8).begin()]);
+	configToGolem(src.head.pos, &dst.cpos[chainJoints[8]]);
+	configToGolem(src.head.vel, &dst.cvel[chainJoints[8]]);
+	configToGolem(src.head.acc, &dst.cacc[chainJoints[8]]);
 }
 
 //-----------------------------------------------------------------------------
@@ -4,6 +4,20 @@
 #include <Golem/Phys/Data.h>
 #include <Golem/Tools/Data.h>
 #include <pcl/io/pcd_io.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#ifdef WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace pacman;
 using namespace golem;
@@ -32,66 +46,125 @@ void BhamGraspImpl::load(const std::string& path) {
 }
 
 void BhamGraspImpl::estimate(const Point3D::Seq& points, Trajectory::Seq& trajectories) {
+	estimate(points, Selection(), trajectories);
+}
+
+void BhamGraspImpl::estimate(const Point3D::Seq& points, const Selection& selection, Trajectory::Seq& trajectories, Handler handler) {
 	// transform data
 	Cloud::PointSeq cloud;
 	convert(points, cloud);
-	estimate(cloud, trajectories);
+	estimate(cloud, selection, trajectories, handler);
 }
 
 void BhamGraspImpl::estimate(const ::grasp::Cloud::PointSeq& points, Trajectory::Seq& trajectories) {
+	estimate(points, Selection(), trajectories);
+}
+
+void BhamGraspImpl::estimate(const ::grasp::Cloud::PointSeq& points, const Selection& selection, Trajectory::Seq& trajectories, Handler handler) {
 	auto ptr = getPtr<Data>(currentDataPtr);
 	if (ptr == nullptr)
 		throw Message(Message::LEVEL_ERROR, "BhamGraspImpl::estimate(): invalid current data pointer");
+	if (!selection.isValid())
+		throw Message(Message::LEVEL_ERROR, "BhamGraspImpl::estimate(): invalid grasp selection");
 
 	// estimate
 	classifier->find(points, ptr->graspConfigs);
+	// low grasps and the least likely candidates are not ranked at all
+	if (selection.prefilter) {
+		const Real elevation = (Real)selection.elevation;
+		ptr->graspConfigs.erase(std::remove_if(ptr->graspConfigs.begin(), ptr->graspConfigs.end(), [=] (const Grasp::Config::Ptr& config) -> bool {
+			return config->path.getGrip().p.z < elevation;
+		}), ptr->graspConfigs.end());
+		if (selection.candidates > 0 && ptr->graspConfigs.size() > (size_t)selection.candidates) {
+			std::nth_element(ptr->graspConfigs.begin(), ptr->graspConfigs.begin() + (selection.candidates - 1), ptr->graspConfigs.end(), [] (const Grasp::Config::Ptr& l, const Grasp::Config::Ptr& r) -> bool {
+				return l->likelihood.value > r->likelihood.value;
+			});
+			ptr->graspConfigs.resize((size_t)selection.candidates);
+		}
+	}
 	// sort by likelihood
 	Cluster::findLikelihood(clusterDesc, ptr->graspConfigs, ptr->graspClusters);
 
-	// HACK: max reliable grasps, filtering
-	golem::U32 grasps = 500, j = 0;
-	Real elevation = Real(0.1);
+	// the best candidates above the elevation, the grasps themselves are kept for display
+	const size_t candidates = selection.candidates > 0 ? std::min((size_t)selection.candidates, ptr->graspConfigs.size()) : ptr->graspConfigs.size();
+	std::vector<size_t> selected;
+	selected.reserve(std::min((size_t)selection.size, candidates));
+	for (size_t i = 0; i < candidates && selected.size() < (size_t)selection.size; ++i)
+		if (ptr->graspConfigs[i]->path.getGrip().p.z >= (Real)selection.elevation)
+			selected.push_back(i);
 
-	// export trajectories, transform to the hand frame
+	// export trajectories, transform to the hand frame, each one to its own preallocated slot
+	const size_t size = selected.size();
 	trajectories.clear();
+	trajectories.resize(size);
 	const golem::Mat34 trn = manipulator->getBaseFrame();
-	for (auto i: ptr->graspConfigs) {
-		Trajectory trajectory;
-		
-		// HACK: filtering
-		if (++j > grasps)
-			break;
-		if (i->path.getGrip().p.z < elevation)
-			continue;
 
-		// order of elements
-		const bool reverse = i->path.getGripIndex() <= 0; // i.e. trajectory starts from the grip
+	// trajectories are passed on in order of likelihood, as soon as all better ones are ready
+	std::vector<bool> ready(size, false);
+	size_t next = 0, delivered = 0;
+	bool stop = false;
+	CriticalSection cs;
+	auto exportTrajectories = [&] () {
+		for (;;) {
+			// select next candidate
+			size_t index;
+			{
+				CriticalSectionWrapper csw(cs);
+				if (stop || next >= size)
+					break;
+				index = next++;
+			}
+
+			auto i = ptr->graspConfigs[selected[index]];
+			Trajectory& trajectory = trajectories[index];
+
+			// order of elements
+			const bool reverse = i->path.getGripIndex() <= 0; // i.e. trajectory starts from the grip
 
-		// extrapolate
-		Grasp::Waypoint::Seq path = i->path;
-		const golem::Real t = reverse ? -trjExtrapolFac : trjExtrapolFac;
-		const Grasp::Waypoint waypoint(manipulator->interpolate(path, t), t);
-		path.insert(reverse ? path.begin() : path.end(), waypoint);
+			// extrapolate
+			const Grasp::Waypoint::Seq& path = i->path;
+			const golem::Real t = reverse ? -trjExtrapolFac : trjExtrapolFac;
+			const Grasp::Waypoint waypoint(manipulator->interpolate(path, t), t);
 
-		// trajectory
-		for (Grasp::Waypoint::Seq::const_iterator j = path.begin(); j != path.end(); ++j) {
 			// convert
-			SchunkDexHand::Pose pose;
-			convert(*j, pose.config);
-			golem::Mat34 frame;
-			frame.multiply(j->toMat34(), trn);
-			frame.p.get(&pose.pose.p.x);
-			frame.R.getRow33(&pose.pose.R.m11);
-
-			// always from pre-grasp to grasp
-			trajectory.trajectory.insert(reverse ? trajectory.trajectory.begin() : trajectory.trajectory.end(), pose);
+			auto toPose = [&] (const Grasp::Waypoint& w) -> SchunkDexHand::Pose {
+				SchunkDexHand::Pose pose;
+				convert(w, pose.config);
+				golem::Mat34 frame;
+				frame.multiply(w.toMat34(), trn);
+				frame.p.get(&pose.pose.p.x);
+				frame.R.getRow33(&pose.pose.R.m11);
+				return pose;
+			};
+
+			// always from pre-grasp to grasp, followed by the extrapolated waypoint
+			trajectory.trajectory.reserve(path.size() + 1);
+			for (Grasp::Waypoint::Seq::const_iterator j = path.begin(); j != path.end(); ++j)
+				trajectory.trajectory.push_back(toPose(*j));
+			if (reverse)
+				std::reverse(trajectory.trajectory.begin(), trajectory.trajectory.end());
+			trajectory.trajectory.push_back(toPose(waypoint));
+
+			// likelihood
+			trajectory.likelihood = (float_t)i->likelihood.value;
+
+			// pass on as soon as it is ready
+			{
+				CriticalSectionWrapper csw(cs);
+				ready[index] = true;
+				for (; !stop && delivered < size && ready[delivered]; ++delivered)
+					if (handler && !handler(trajectories[delivered]))
+						stop = true;
+			}
 		}
-		
-		// likelihood
-		trajectory.likelihood = (float_t)i->likelihood.value;
-		
-		trajectories.push_back(trajectory);
-	}
+	};
+	if (context.getParallels() != nullptr)
+		ParallelsTask(context.getParallels(), [&] (ParallelsTask*) { exportTrajectories(); });
+	else
+		exportTrajectories();
+	// drop the ones behind a stop request
+	if (stop)
+		trajectories.resize(delivered);
 
 	// display
 	ptr->points[Cloud::LABEL_OBJECT] = points;
@@ -128,7 +201,7 @@ void BhamGraspImpl::function(Data::Map::iterator& dataPtr, int key) {
 	switch (key) {
 	case 'A':
 	{
-		switch (waitKey("IE", "Press a key to (I)mport/(E)xport data...")) {
+		switch (waitKey("IEC", "Press a key to (I)mport/(E)xport/(C)onvert data...")) {
 		case 'I':
 		{
 			const int key = waitKey("PT", "Press a key to import (P)oint cloud/(T)trajectory...");
@@ -167,13 +240,30 @@ void BhamGraspImpl::function(Data::Map::iterator& dataPtr, int key) {
 			}
 			// appproach trajectory
 			if (key == 'T') {
+				const int format = waitKey("TB", "Press a key to export as (T)ext/(B)inary...");
 				context.write("Exporting approach trajectory to: %s\n", path.c_str());
 				RobotUIBK::Config::Seq seq;
 				//convert(to<Data>(dataPtr)->actionApproach, seq);
-				pacman::save(path, seq);
+				if (format == 'B')
+					pacman::saveBinary(path, seq);
+				else
+					pacman::save(path, seq);
 			}
 			break;
 		}
+		case 'C':
+		{
+			// recorded trajectories are converted once, so that replay tools load them without parsing
+			std::string path = data->path;
+			readString("Enter trajectory file path: ", path);
+			std::string pathBinary = path + ".bin";
+			readString("Enter binary trajectory file path: ", pathBinary);
+			context.write("Converting approach trajectory from: %s to: %s\n", path.c_str(), pathBinary.c_str());
+			RobotUIBK::Config::Seq seq;
+			pacman::load(path, seq);
+			pacman::saveBinary(pathBinary, seq);
+			break;
+		}
 		}
 		context.write("Done!\n");
 		break;
@@ -220,10 +310,167 @@ void BhamGraspImpl::convert(const Point3D::Seq& src, ::grasp::Cloud::PointSeq& d
 		dst.push_back(point);
 	}
 
-	Cloud::curvature(context, cloudDesc.curvature, dst);
+	featureCache.compute(dst, [&] (Cloud::PointSeq& points) {
+		Cloud::curvature(context, cloudDesc.curvature, points);
+	});
 	Cloud::nanRem(context, dst, Cloud::isNanXYZNormalCurvature<Cloud::Point>);
 }
 
+namespace {
+const std::uint32_t POINT_NONE = std::uint32_t(-1);
+
+inline bool isFinite(const Cloud::Point& point) {
+	return std::isfinite(point.x) && std::isfinite(point.y) && std::isfinite(point.z);
+}
+
+/** Input of the feature computation */
+inline bool isEqual(const Cloud::Point& a, const Cloud::Point& b) {
+	return a.x == b.x && a.y == b.y && a.z == b.z && a.normal_x == b.normal_x && a.normal_y == b.normal_y && a.normal_z == b.normal_z;
+}
+
+/** Output of the feature computation */
+inline void copyFeatures(const Cloud::Point& src, Cloud::Point& dst) {
+	dst.normal_x = src.normal_x;
+	dst.normal_y = src.normal_y;
+	dst.normal_z = src.normal_z;
+	dst.curvature = src.curvature;
+}
+
+inline std::int32_t voxel(Real radius, float x) {
+	return (std::int32_t)std::floor(x/radius);
+}
+
+/** 21 bits per axis, voxels which wrap around to the same key are told apart by distance */
+inline std::uint64_t voxelKey(std::int32_t x, std::int32_t y, std::int32_t z) {
+	const std::uint64_t mask = (std::uint64_t(1) << 21) - 1;
+	return (std::uint64_t(x) & mask) | ((std::uint64_t(y) & mask) << 21) | ((std::uint64_t(z) & mask) << 42);
+}
+}
+
+void BhamGraspImpl::FeatureCache::build(const Cloud::PointSeq& points, Index& index) const {
+	index.clear();
+	index.reserve(points.size());
+	for (std::uint32_t i = 0; i < (std::uint32_t)points.size(); ++i) {
+		const Cloud::Point& point = points[i];
+		if (isFinite(point))
+			index.push_back(std::make_pair(voxelKey(voxel(radius, point.x), voxel(radius, point.y), voxel(radius, point.z)), i));
+	}
+	std::sort(index.begin(), index.end());
+}
+
+template <typename _Func> void BhamGraspImpl::FeatureCache::neighbours(const Cloud::PointSeq& points, const Index& index, const Cloud::Point& point, _Func func) const {
+	const std::int32_t x = voxel(radius, point.x), y = voxel(radius, point.y), z = voxel(radius, point.z);
+	const Real radiusSqr = radius*radius;
+	for (std::int32_t ix = x - 1; ix <= x + 1; ++ix)
+		for (std::int32_t iy = y - 1; iy <= y + 1; ++iy)
+			for (std::int32_t iz = z - 1; iz <= z + 1; ++iz) {
+				const std::uint64_t key = voxelKey(ix, iy, iz);
+				for (Index::const_iterator i = std::lower_bound(index.begin(), index.end(), std::make_pair(key, std::uint32_t(0))); i != index.end() && i->first == key; ++i) {
+					const Cloud::Point& neighbour = points[i->second];
+					const Real dx = Real(neighbour.x - point.x), dy = Real(neighbour.y - point.y), dz = Real(neighbour.z - point.z);
+					if (dx*dx + dy*dy + dz*dz <= radiusSqr)
+						func(i->second);
+				}
+			}
+}
+
+void BhamGraspImpl::FeatureCache::compute(Cloud::PointSeq& points, Compute func) {
+	CriticalSectionWrapper csw(cs);
+
+	Cloud::PointSeq current(points);
+	Index currentIndex;
+	build(current, currentIndex);
+
+	bool full = !enabled || input.empty() || points.empty();
+	if (!full) {
+		// match points which have not changed with the previous input
+		std::vector<std::uint32_t> match(points.size(), POINT_NONE);
+		std::vector<bool> matched(input.size(), false);
+		for (Index::const_iterator i = currentIndex.begin(); i != currentIndex.end(); ++i) {
+			const Cloud::Point& point = points[i->second];
+			for (Index::const_iterator j = std::lower_bound(index.begin(), index.end(), std::make_pair(i->first, std::uint32_t(0))); j != index.end() && j->first == i->first; ++j)
+				if (!matched[j->second] && isEqual(point, input[j->second])) {
+					match[i->second] = j->second;
+					matched[j->second] = true;
+					break;
+				}
+		}
+
+		// a point is recomputed if it has changed, or if a point within the radius has been added, moved or removed
+		std::vector<bool> dirty(points.size(), false);
+		auto mark = [&] (std::uint32_t i) {
+			dirty[i] = true;
+		};
+		for (Index::const_iterator i = currentIndex.begin(); i != currentIndex.end(); ++i)
+			if (match[i->second] == POINT_NONE)
+				neighbours(current, currentIndex, current[i->second], mark);
+		for (Index::const_iterator j = index.begin(); j != index.end(); ++j)
+			if (!matched[j->second])
+				neighbours(current, currentIndex, input[j->second], mark);
+
+		std::vector<std::uint32_t> subset;
+		for (std::uint32_t i = 0; i < (std::uint32_t)points.size(); ++i)
+			if (dirty[i])
+				subset.push_back(i);
+		const std::uintptr_t dirtySize = subset.size();
+
+		if (Real(dirtySize) > maxDirty*Real(points.size()))
+			full = true;
+		else {
+			// unchanged neighbourhoods
+			for (std::uint32_t i = 0; i < (std::uint32_t)points.size(); ++i)
+				if (!dirty[i] && match[i] != POINT_NONE)
+					copyFeatures(output[match[i]], points[i]);
+
+			if (dirtySize > 0) {
+				// dirty points together with their neighbours are all the radius search can see
+				std::vector<bool> selected(dirty);
+				for (std::uintptr_t k = 0; k < dirtySize; ++k)
+					neighbours(current, currentIndex, current[subset[k]], [&] (std::uint32_t i) {
+						if (!selected[i]) {
+							selected[i] = true;
+							subset.push_back(i);
+						}
+					});
+
+				Cloud::PointSeq seq;
+				seq.reserve(subset.size());
+				for (std::vector<std::uint32_t>::const_iterator i = subset.begin(); i != subset.end(); ++i)
+					seq.push_back(current[*i]);
+				func(seq);
+
+				if (seq.size() != subset.size())
+					full = true;
+				else
+					for (std::uintptr_t k = 0; k < dirtySize; ++k)
+						copyFeatures(seq[k], points[subset[k]]);
+			}
+		}
+	}
+
+	if (full) {
+		points = current;
+		func(points);
+	}
+
+	input.swap(current);
+	index.swap(currentIndex);
+	output = points;
+	if (output.size() != input.size()) {
+		// the computation does not keep points in place, nothing can be reused
+		input.clear();
+		output.clear();
+		index.clear();
+	}
+}
+
+void BhamGraspImpl::FeatureCache::clear() {
+	CriticalSectionWrapper csw(cs);
+	input.clear();
+	output.clear();
+	index.clear();
+}
+
 void BhamGraspImpl::convert(const ::grasp::Manipulator::Config& src, SchunkDexHand::Config& dst) const {
 	const std::uintptr_t offset = manipulator->getArmJoints();
 	configToPacman(src.jc + manipulator->getArmJoints(), dst);
@@ -280,6 +527,91 @@ void BhamGraspImpl::convert(const RobotUIBK::Config::Seq& src, ::grasp::Robot::S
 
 //-----------------------------------------------------------------------------
 
+namespace {
+/** Binary trajectory file header, followed by size*joints doubles in the native (little-endian) byte order */
+struct TrajectoryHeader {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t joints;
+	std::uint64_t size;
+	std::uint64_t checksum;
+};
+const char TRAJECTORY_MAGIC[8] = {'P', 'a', 'C', 'M', 'T', 'R', 'J', '\0'};
+const std::uint32_t TRAJECTORY_VERSION = 1;
+
+/** FNV-1a over 64-bit words, size must be a multiple of 8 */
+std::uint64_t trajectoryChecksum(const char* data, std::uintptr_t size) {
+	std::uint64_t hash = 14695981039346656037ULL;
+	for (const char* end = data + size; data < end; data += sizeof(std::uint64_t)) {
+		std::uint64_t word;
+		std::memcpy(&word, data, sizeof(word));
+		hash = (hash ^ word)*1099511628211ULL;
+	}
+	return hash;
+}
+
+/** Read-only memory mapped file */
+class MappedFile {
+public:
+	MappedFile(const std::string& path) : ptr(nullptr), length(0) {
+#ifdef WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			throw Message(Message::LEVEL_CRIT, "pacman::load(): '%s' not found!", path.c_str());
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(file, &size))
+			length = (std::uintptr_t)size.QuadPart;
+		if (length > 0) {
+			HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping != NULL) {
+				ptr = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mapping);
+			}
+		}
+		CloseHandle(file);
+#else
+		const int file = ::open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			throw Message(Message::LEVEL_CRIT, "pacman::load(): '%s' not found!", path.c_str());
+		struct stat st;
+		if (::fstat(file, &st) == 0)
+			length = (std::uintptr_t)st.st_size;
+		if (length > 0) {
+			void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapping != MAP_FAILED)
+				ptr = (const char*)mapping;
+		}
+		::close(file);
+#endif
+		if (length > 0 && ptr == nullptr)
+			throw Message(Message::LEVEL_CRIT, "pacman::load(): unable to map '%s'", path.c_str());
+	}
+	~MappedFile() {
+		if (ptr == nullptr)
+			return;
+#ifdef WIN32
+		UnmapViewOfFile(ptr);
+#else
+		::munmap(const_cast<char*>(ptr), length);
+#endif
+	}
+
+	const char* data() const {
+		return ptr;
+	}
+	std::uintptr_t size() const {
+		return length;
+	}
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator = (const MappedFile&);
+
+	const char* ptr;
+	std::uintptr_t length;
+};
+}
+
 void pacman::save(const std::string& path, const Point3D::Seq& points) {
 	pcl::PointCloud<pcl::PointXYZRGBNormal> pclCloud;
 	pacman::convert(points, pclCloud);
@@ -315,7 +647,61 @@ void pacman::save(const std::string& path, const RobotUIBK::Config::Seq& traject
 	}
 }
 
+void pacman::saveBinary(const std::string& path, const RobotUIBK::Config::Seq& trajectory) {
+	// pack configs
+	std::vector<double> data;
+	data.reserve(trajectory.size()*RobotUIBK::Config::JOINTS);
+	for (auto i: trajectory) {
+		data.insert(data.end(), i.arm.c, i.arm.c + KukaLWR::Config::JOINTS);
+		data.insert(data.end(), i.hand.c, i.hand.c + SchunkDexHand::Config::JOINTS);
+	}
+
+	TrajectoryHeader header;
+	std::memcpy(header.magic, TRAJECTORY_MAGIC, sizeof(header.magic));
+	header.version = TRAJECTORY_VERSION;
+	header.joints = (std::uint32_t)RobotUIBK::Config::JOINTS;
+	header.size = (std::uint64_t)trajectory.size();
+	header.checksum = trajectoryChecksum((const char*)data.data(), data.size()*sizeof(double));
+
+	// open a file
+	std::ofstream file(path, std::ios::binary);
+	if (!file.good())
+		throw Message(Message::LEVEL_CRIT, "pacman::saveBinary(): could not open '%s' file!", path.c_str());
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)data.data(), data.size()*sizeof(double));
+	if (!file.good())
+		throw Message(Message::LEVEL_CRIT, "pacman::saveBinary(): could not write '%s' file!", path.c_str());
+}
+
 void pacman::load(const std::string& path, RobotUIBK::Config::Seq& trajectory) {
+	// binary format, mapped to memory and copied in one pass
+	{
+		const MappedFile mapped(path); // throws
+		if (mapped.size() >= sizeof(TrajectoryHeader) && std::memcmp(mapped.data(), TRAJECTORY_MAGIC, sizeof(TRAJECTORY_MAGIC)) == 0) {
+			TrajectoryHeader header;
+			std::memcpy(&header, mapped.data(), sizeof(header));
+			if (header.version != TRAJECTORY_VERSION)
+				throw Message(Message::LEVEL_CRIT, "pacman::load(): '%s' unsupported version %u", path.c_str(), header.version);
+			if (header.joints != (std::uint32_t)RobotUIBK::Config::JOINTS)
+				throw Message(Message::LEVEL_CRIT, "pacman::load(): '%s' invalid number of joints %u", path.c_str(), header.joints);
+			const std::uintptr_t size = (std::uintptr_t)header.size*RobotUIBK::Config::JOINTS*sizeof(double);
+			if (mapped.size() != sizeof(TrajectoryHeader) + size)
+				throw Message(Message::LEVEL_CRIT, "pacman::load(): '%s' invalid file size", path.c_str());
+			const char* data = mapped.data() + sizeof(TrajectoryHeader);
+			if (trajectoryChecksum(data, size) != header.checksum)
+				throw Message(Message::LEVEL_CRIT, "pacman::load(): '%s' checksum mismatch", path.c_str());
+
+			trajectory.resize((std::uintptr_t)header.size);
+			const double* c = (const double*)data;
+			for (RobotUIBK::Config::Seq::iterator i = trajectory.begin(); i != trajectory.end(); ++i, c += RobotUIBK::Config::JOINTS) {
+				std::copy(c, c + KukaLWR::Config::JOINTS, i->arm.c);
+				std::copy(c + KukaLWR::Config::JOINTS, c + RobotUIBK::Config::JOINTS, i->hand.c);
+			}
+			return;
+		}
+	}
+
 	// open a file
 	std::ifstream file(path);
 	if (!file.good())
@@ -376,6 +762,30 @@ BhamGrasp::Ptr BhamGrasp::create(const std::string& path) {
 	if (pBhamGrasp == NULL)
 		throw Message(Message::LEVEL_CRIT, "BhamGrasp::create(): Unable to create Birmingham grasp interface");
 
+	// Feature cache of the point cloud conversion, optional
+	try {
+		XMLData("enabled", pBhamGrasp->featureCache.enabled, pXMLContext->getContextFirst("feature_cache"));
+		XMLData("max_dirty", pBhamGrasp->featureCache.maxDirty, pXMLContext->getContextFirst("feature_cache"));
+	}
+	catch (const MsgXMLParserNameNotFound&) {
+	}
+	// the cache radius is the reach of the feature computation, so a larger search radius never reuses stale features
+	try {
+		Real curvatureRadius = REAL_ZERO, normalRadius = REAL_ZERO;
+		bool normals = false;
+		XMLData("radius_search", curvatureRadius, pXMLContext->getContextFirst("director cloud curvature"));
+		XMLData("normals", normals, pXMLContext->getContextFirst("director cloud curvature"));
+		if (normals)
+			XMLData("radius_search", normalRadius, pXMLContext->getContextFirst("director cloud normal"));
+		pBhamGrasp->featureCache.radius = curvatureRadius + normalRadius;
+		if (!(pBhamGrasp->featureCache.radius > REAL_ZERO))
+			throw Message(Message::LEVEL_CRIT, "BhamGrasp::create(): invalid feature search radius %f", pBhamGrasp->featureCache.radius);
+	}
+	catch (const MsgXMLParserNameNotFound&) {
+		// unknown reach, every estimate recomputes all features
+		pBhamGrasp->featureCache.enabled = false;
+	}
+
 	// Random number generator seed
 	context->info("Random number generator seed %d\n", context->getRandSeed()._U32[0]);
 
@@ -1,5 +1,6 @@
 #include <pacman/Bham/Grasp/Grasp.h>
 #include <exception>
+#include <string>
 
 #include <pacman/Bham/Grasp/GraspImpl.h> // Fast method
 
@@ -7,8 +8,16 @@ using namespace pacman;
 
 int main(int argc, char *argv[]) {
 	try {
+		// convert a recorded trajectory to the binary format, e.g. for replay tools
+		if (argc == 4 && std::string(argv[1]) == "--convert") {
+			RobotUIBK::Config::Seq trajectory;
+			load(argv[2], trajectory);
+			saveBinary(argv[3], trajectory);
+			return 0;
+		}
 		if (argc < 2) {
 			printf("GraspTest <configuration_file>\n");
+			printf("GraspTest --convert <trajectory_file> <binary_trajectory_file>\n");
 			return 1;
 		}
 
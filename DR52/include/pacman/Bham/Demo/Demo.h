@@ -15,6 +15,15 @@
 #include <Grasp/Core/Ctrl.h>
 #include <Grasp/Contact/Query.h>
 #include <Grasp/Contact/Manipulator.h>
+#include <pacman/Bham/Demo/KernelBatch.h>
+#include <pacman/Bham/Demo/WorkCursor.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <vector>
 
 //------------------------------------------------------------------------------
 
@@ -29,6 +38,167 @@ public:
 	/** Model/Query any identifier */
 	static const std::string ID_ANY;
 
+	/** Kernel density spatial index: a uniform grid over kernel positions, with cells as large as the largest kernel support.
+	*	A sample can only be within support of kernels in the 27 cells around it.
+	*/
+	class KernelIndex {
+	public:
+		/** Kernel indices */
+		typedef std::vector<golem::U32> IndexSeq;
+		/** Ranges [first, second) of kernel indices grouped by cell */
+		typedef std::vector<std::pair<golem::U32, golem::U32> > RangeSeq;
+
+		KernelIndex() : cellSize(golem::REAL_ZERO) {}
+
+		/** Builds the index, kernels must not change until the next call */
+		template <typename _Seq> void create(const _Seq& kernels) {
+			clear();
+			for (typename _Seq::const_iterator i = kernels.begin(); i != kernels.end(); ++i)
+				cellSize = std::max(cellSize, golem::Math::sqrt(i->distMax.lin));
+			// kernels with unbounded support are evaluated linearly
+			if (kernels.empty() || !(cellSize > golem::REAL_ZERO && cellSize < golem::numeric_const<golem::Real>::MAX)) {
+				cellSize = golem::REAL_ZERO;
+				return;
+			}
+
+			// kernels grouped by cell, in ascending order within a cell
+			std::vector<std::pair<std::uint64_t, golem::U32> > keys;
+			keys.reserve(kernels.size());
+			for (golem::U32 i = 0; i < (golem::U32)kernels.size(); ++i)
+				keys.push_back(std::make_pair(getKey(kernels[i].p), i));
+			std::sort(keys.begin(), keys.end());
+
+			size_t cells = 0;
+			for (size_t i = 0; i < keys.size(); ++i)
+				if (i == 0 || keys[i].first != keys[i - 1].first)
+					++cells;
+			size_t tableSize = 1;
+			while (tableSize < 2*cells)
+				tableSize <<= 1;
+			table.assign(tableSize, Cell());
+
+			indices.reserve(keys.size());
+			for (size_t i = 0; i < keys.size();) {
+				Cell cell;
+				cell.key = keys[i].first;
+				cell.begin = (golem::U32)indices.size();
+				for (; i < keys.size() && keys[i].first == cell.key; ++i)
+					indices.push_back(keys[i].second);
+				cell.end = (golem::U32)indices.size();
+				size_t slot = getSlot(cell.key);
+				while (table[slot].begin != table[slot].end)
+					slot = (slot + 1) & (table.size() - 1);
+				table[slot] = cell;
+			}
+		}
+		/** Removes all kernels */
+		void clear() {
+			cellSize = golem::REAL_ZERO;
+			table.clear();
+			indices.clear();
+		}
+		/** No index, all kernels have to be visited */
+		bool empty() const {
+			return table.empty();
+		}
+
+		/** Indices of kernels which can be within support of the position, in ascending order */
+		void find(const golem::Vec3& p, IndexSeq& seq) const {
+			seq.clear();
+			forEachCell(p, [&] (const Cell& cell) {
+				seq.insert(seq.end(), indices.begin() + cell.begin, indices.begin() + cell.end);
+			});
+			std::sort(seq.begin(), seq.end());
+		}
+		/** Ranges of getIndices() with kernels which can be within support of the position, one per cell */
+		void find(const golem::Vec3& p, RangeSeq& seq) const {
+			seq.clear();
+			forEachCell(p, [&] (const Cell& cell) {
+				seq.push_back(std::make_pair(cell.begin, cell.end));
+			});
+		}
+		/** Kernel indices grouped by cell */
+		const IndexSeq& getIndices() const {
+			return indices;
+		}
+
+		/** Cells around several positions, each cell with all the positions around it */
+		class Sweep {
+		public:
+			/** Ranges around each position in the order of find(), those of position i are [offsets[i], offsets[i + 1]) */
+			RangeSeq ranges;
+			std::vector<golem::U32> offsets;
+			/** Position of each range */
+			std::vector<golem::U32> positions;
+			/** Range begin and range index, sorted so that the ranges of a cell are next to each other */
+			std::vector<std::pair<golem::U32, golem::U32> > order;
+			/** Sum of each range */
+			std::vector<golem::Real> sums;
+
+			/** Finds the cells around the positions */
+			template <typename _Ptr> void create(const KernelIndex& index, _Ptr begin, _Ptr end) {
+				ranges.clear();
+				offsets.assign(1, 0);
+				positions.clear();
+				for (_Ptr i = begin; i != end; ++i) {
+					index.forEachCell(i->p, [&] (const Cell& cell) {
+						ranges.push_back(std::make_pair(cell.begin, cell.end));
+					});
+					positions.resize(ranges.size(), (golem::U32)offsets.size() - 1);
+					offsets.push_back((golem::U32)ranges.size());
+				}
+				order.resize(ranges.size());
+				for (size_t i = 0; i < ranges.size(); ++i)
+					order[i] = std::make_pair(ranges[i].first, (golem::U32)i);
+				std::sort(order.begin(), order.end());
+				sums.resize(ranges.size());
+			}
+		};
+
+	private:
+		/** Cell in the open addressing hash table, empty if begin == end */
+		struct Cell {
+			std::uint64_t key;
+			golem::U32 begin, end;
+			Cell() : key(0), begin(0), end(0) {}
+		};
+
+		std::int64_t getCoord(golem::Real x) const {
+			// far away positions share the outermost cells, the kernel support test still applies
+			const golem::Real limit = golem::Real(1 << 20);
+			return (std::int64_t)std::floor(std::max(-limit, std::min(limit, x/cellSize)));
+		}
+		/** 21 bits per axis */
+		static std::uint64_t getKey(std::int64_t x, std::int64_t y, std::int64_t z) {
+			const std::uint64_t mask = (std::uint64_t(1) << 21) - 1;
+			return (std::uint64_t(x) & mask) | ((std::uint64_t(y) & mask) << 21) | ((std::uint64_t(z) & mask) << 42);
+		}
+		std::uint64_t getKey(const golem::Vec3& p) const {
+			return getKey(getCoord(p.x), getCoord(p.y), getCoord(p.z));
+		}
+		size_t getSlot(std::uint64_t key) const {
+			return size_t((key*std::uint64_t(0x9E3779B97F4A7C15)) >> 32) & (table.size() - 1);
+		}
+		/** Non-empty cells around the position */
+		template <typename _Func> void forEachCell(const golem::Vec3& p, _Func func) const {
+			const std::int64_t x = getCoord(p.x), y = getCoord(p.y), z = getCoord(p.z);
+			for (std::int64_t ix = x - 1; ix <= x + 1; ++ix)
+				for (std::int64_t iy = y - 1; iy <= y + 1; ++iy)
+					for (std::int64_t iz = z - 1; iz <= z + 1; ++iz) {
+						const std::uint64_t key = getKey(ix, iy, iz);
+						for (size_t slot = getSlot(key); table[slot].begin != table[slot].end; slot = (slot + 1) & (table.size() - 1))
+							if (table[slot].key == key) {
+								func(table[slot]);
+								break;
+							}
+					}
+		}
+
+		golem::Real cellSize;
+		std::vector<Cell> table;
+		IndexSeq indices;
+	};
+
 	/** Data */
 	class Data : public grasp::Player::Data {
 	public:
@@ -89,6 +259,15 @@ public:
 			grasp::data::Point3D::Point::Seq locations;
 			/** End-effector frame */
 			golem::Mat34 frame;
+
+			/** Object density index, not serialised */
+			KernelIndex objectIndex;
+			/** Pose density index, not serialised */
+			KernelIndex poseIndex;
+			/** Object density kernel arrays in the object index order, not serialised */
+			KernelBatch objectBatch;
+			/** Pose density kernel arrays in the pose index order, not serialised */
+			KernelBatch poseBatch;
 		};
 
 		/** Solution */
@@ -150,6 +329,15 @@ public:
 
 			/** Query index */
 			golem::U32 queryIndex;
+
+			/** Exchanges contents without copying the path */
+			void swap(Solution& solution) {
+				type.swap(solution.type);
+				std::swap(pose, solution.pose);
+				path.swap(solution.path);
+				std::swap(likelihood, solution.likelihood);
+				std::swap(queryIndex, solution.queryIndex);
+			}
 		};
 
 		/** Cluster */
@@ -299,10 +487,29 @@ public:
 	/** Optimisation description */
 	class Optimisation {
 	public:
+		/** Simulated annealing temperature schedule */
+		enum Schedule {
+			/** Temperature falls linearly from 1 to saTemp */
+			SCHEDULE_LINEAR,
+			/** Temperature falls geometrically from 1 to saTemp, requires saTemp > 0 */
+			SCHEDULE_EXPONENTIAL,
+			/** Temperature of each run follows its acceptance rate towards saAcceptRate */
+			SCHEDULE_ADAPTIVE,
+		};
+		/** Search strategy */
+		enum Search {
+			/** Runs are independent */
+			SEARCH_INDEPENDENT,
+			/** Runs advanced together share a query density and exchange temperatures (parallel tempering) */
+			SEARCH_TEMPERING,
+		};
+
 		/** number of runs */
 		size_t runs;
 		/** number of steps per run */
 		size_t steps;
+		/** number of runs advanced together by each thread */
+		size_t chains;
 
 		/** Simulated annealing minimum temperature */
 		golem::Real saTemp;
@@ -311,6 +518,20 @@ public:
 		/** Simulated annealing temperature to energy scaling factor */
 		golem::Real saEnergy;
 
+		/** Temperature schedule */
+		Schedule schedule;
+		/** Adaptive schedule target acceptance rate */
+		golem::Real saAcceptRate;
+		/** A run stops after this number of steps without improvement, its remaining steps are given to runs which still improve; 0 to disable */
+		size_t saPatience;
+		/** Smallest relative likelihood increase which counts as improvement */
+		golem::Real saTolerance;
+
+		/** Search strategy */
+		Search search;
+		/** Parallel tempering temperature ratio of adjacent replicas */
+		golem::Real ptLadder;
+
 		/** Constructs description object */
 		Optimisation() {
 			Optimisation::setToDefault();
@@ -319,21 +540,147 @@ public:
 		void setToDefault() {
 			runs = 1000;
 			steps = 1000;
+			chains = 8;
 
 			saTemp = golem::Real(0.1);
 			saDelta.set(golem::Real(1.0), golem::Real(1.0));
 			saEnergy = golem::Real(0.5);
+
+			schedule = SCHEDULE_LINEAR;
+			saAcceptRate = golem::Real(0.25);
+			saPatience = 0;
+			saTolerance = golem::Real(1e-3);
+
+			search = SEARCH_INDEPENDENT;
+			ptLadder = golem::Real(1.5);
 		}
 		/** Assert that the description is valid. */
 		void assertValid(const grasp::Assert::Context& ac) const {
 			grasp::Assert::valid(runs > 0, ac, "runs: <= 0");
 			grasp::Assert::valid(steps > 0, ac, "steps: <= 0");
+			grasp::Assert::valid(chains > 0, ac, "chains: <= 0");
 			grasp::Assert::valid(saTemp >= golem::REAL_ZERO, ac, "saTemp: < 0");
+			grasp::Assert::valid(schedule != SCHEDULE_EXPONENTIAL || saTemp > golem::REAL_ZERO, ac, "saTemp: <= 0 with exponential schedule");
 			grasp::Assert::valid(saDelta.isValid(), ac, "saDelta: invalid");
 			grasp::Assert::valid(saEnergy > golem::REAL_ZERO, ac, "saEnergy: <= 0");
+			grasp::Assert::valid(saAcceptRate > golem::REAL_ZERO && saAcceptRate < golem::REAL_ONE, ac, "saAcceptRate: not in (0, 1)");
+			grasp::Assert::valid(saTolerance >= golem::REAL_ZERO, ac, "saTolerance: < 0");
+			grasp::Assert::valid(ptLadder >= golem::REAL_ONE, ac, "ptLadder: < 1");
 		}
 		/** Load descritpion from xml context. */
 		void load(const golem::XMLContext* xmlcontext);
+
+		/** Temperature of the linear and exponential schedules at the given step, saTemp past the last step */
+		golem::Real getTemperature(size_t step) const;
+		/** Adaptive schedule: updates the temperature and the running acceptance rate of a run after each step */
+		void updateTemperature(golem::Real& temp, golem::Real& rate, bool accepted) const;
+		/** Temperature factor of a parallel tempering replica, 1 for the coldest one and for independent runs */
+		golem::Real getLadder(size_t rung) const {
+			return search == SEARCH_TEMPERING ? std::pow(ptLadder, golem::Real(rung)) : golem::REAL_ONE;
+		}
+	};
+
+	/** Query densities of training slots, reused while the training data, the query features and the object frame stay the same.
+	*	Entries are identified by a fingerprint of everything a density is created from except the object frame, the least recently used one is evicted first.
+	*/
+	class QueryCache {
+	public:
+		/** Fingerprint */
+		typedef std::uint64_t Key;
+
+		/** Cached density */
+		class Entry {
+		public:
+			/** Density before the object frame is applied, object poses in the query features frame, no locations */
+			Data::Density base;
+			/** Density in the object frame below */
+			Data::Density density;
+			/** Object frame of density */
+			golem::Mat34 frame;
+			/** density is set */
+			bool valid;
+
+			Entry() : valid(false) {}
+		};
+
+		/** Query cache description */
+		class Desc {
+		public:
+			/** Number of entries, 0 disables the cache */
+			size_t capacity;
+			/** Frames closer than this linear distance and rotation angle in radians reuse the density without applying the new frame */
+			grasp::RBDist frameTolerance;
+
+			Desc() {
+				setToDefault();
+			}
+			/** Sets the parameters to the default values */
+			void setToDefault() {
+				capacity = 0;
+				frameTolerance.set(golem::Real(1e-4), golem::Real(1e-4));
+			}
+			/** Assert that the description is valid. */
+			void assertValid(const grasp::Assert::Context& ac) const {
+				grasp::Assert::valid(frameTolerance.lin >= golem::REAL_ZERO && frameTolerance.ang >= golem::REAL_ZERO, ac, "frameTolerance: negative");
+			}
+			/** Load descritpion from xml context. */
+			void load(const golem::XMLContext* xmlcontext);
+		};
+
+		QueryCache() {}
+		/** Sets the description and removes all entries */
+		void create(const Desc& desc) {
+			this->desc = desc;
+			clear();
+		}
+		/** Description */
+		const Desc& getDesc() const {
+			return desc;
+		}
+
+		/** Entry with the key, becomes the most recently used one, nullptr if there is none */
+		Entry* find(Key key) {
+			const Map::iterator i = map.find(key);
+			if (i == map.end())
+				return nullptr;
+			list.splice(list.begin(), list, i->second);
+			return &i->second->second;
+		}
+		/** New entry with the key, evicts the least recently used ones above capacity */
+		Entry& insert(Key key, const Data::Density& base) {
+			const Map::iterator i = map.find(key);
+			if (i != map.end()) {
+				list.erase(i->second);
+				map.erase(i);
+			}
+			list.push_front(std::make_pair(key, Entry()));
+			list.front().second.base = base;
+			map[key] = list.begin();
+			for (; list.size() > std::max(desc.capacity, size_t(1)); list.pop_back())
+				map.erase(list.back().first);
+			return list.front().second;
+		}
+		/** Removes all entries */
+		void clear() {
+			list.clear();
+			map.clear();
+		}
+		/** Number of entries */
+		size_t size() const {
+			return list.size();
+		}
+
+	private:
+		typedef std::list<std::pair<Key, Entry> > List;
+		typedef std::map<Key, List::iterator> Map;
+
+		Desc desc;
+		List list;
+		Map map;
+
+		/** The map refers to the list of the same object, copies are not allowed */
+		QueryCache(const QueryCache&);
+		QueryCache& operator = (const QueryCache&);
 	};
 
 	/** Demo description */
@@ -414,6 +761,8 @@ public:
 		grasp::Query::Desc::Map queryDescMap;
 		/** Pose descriptions */
 		PoseDensity::Map poseMap;
+		/** Query density cache description */
+		QueryCache::Desc queryCacheDesc;
 
 		/** Optimisation description */
 		Optimisation optimisation;
@@ -433,6 +782,8 @@ public:
 		golem::SecTmReal manipulatorTrajectoryDuration;
 		/** Manipulation trajectory force threshold */
 		golem::Twist trajectoryThresholdForce;
+		/** Trajectory error which accepts a candidate without checking less likely ones, zero to check all candidates */
+		grasp::RBDist trajectoryErrAccept;
 
 		/* Withdraw action hand release fraction */
 		golem::Real withdrawReleaseFraction;
@@ -496,6 +847,7 @@ public:
 			queryDescMap.clear();
 			poseMap.clear();
 
+			queryCacheDesc.setToDefault();
 			optimisation.setToDefault();
 
 			manipulatorDesc.reset(new grasp::Manipulator::Desc);
@@ -506,6 +858,7 @@ public:
 
 			manipulatorTrajectoryDuration = golem::SecTmReal(5.0);
 			trajectoryThresholdForce.setZero();
+			trajectoryErrAccept.set(golem::REAL_ZERO, golem::REAL_ZERO);
 
 			withdrawReleaseFraction = golem::Real(0.5);
 			withdrawLiftDistance = golem::Real(0.20);
@@ -572,6 +925,7 @@ public:
 				i->second.assertValid(grasp::Assert::Context(ac, "poseMap[]->"));
 			}
 
+			queryCacheDesc.assertValid(grasp::Assert::Context(ac, "queryCacheDesc."));
 			optimisation.assertValid(grasp::Assert::Context(ac, "optimisation."));
 
 			grasp::Assert::valid(manipulatorDesc != nullptr, ac, "manipulatorDesc: null");
@@ -583,6 +937,8 @@ public:
 
 			grasp::Assert::valid(manipulatorTrajectoryDuration > golem::SEC_TM_REAL_ZERO, ac, "manipulatorTrajectoryDuration: <= 0");
 			grasp::Assert::valid(trajectoryThresholdForce.isPositive(), ac, "trajectoryThresholdForce: negative");
+			grasp::Assert::valid(trajectoryErrAccept.lin >= golem::REAL_ZERO && trajectoryErrAccept.ang >= golem::REAL_ZERO, ac, "trajectoryErrAccept: negative");
+			grasp::Assert::valid((trajectoryErrAccept.lin > golem::REAL_ZERO) == (trajectoryErrAccept.ang > golem::REAL_ZERO), ac, "trajectoryErrAccept: lin and ang must be both zero or both positive");
 
 			grasp::Assert::valid(withdrawReleaseFraction >= golem::REAL_ZERO, ac, "withdrawReleaseFraction: < 0");
 			grasp::Assert::valid(withdrawReleaseFraction <= golem::REAL_ONE,  ac, "withdrawReleaseFraction: > 1");
@@ -678,6 +1034,8 @@ protected:
 	grasp::Query::Map queryMap;
 	/** Pose descriptions */
 	PoseDensity::Map poseMap;
+	/** Query density cache */
+	QueryCache queryCache;
 
 	/** Optimisation description */
 	Optimisation optimisation;
@@ -698,6 +1056,17 @@ protected:
 
 	/** Manipulation trajectory force threshold */
 	golem::Twist trajectoryThresholdForce;
+	/** Trajectory error which accepts a candidate without checking less likely ones */
+	grasp::RBDist trajectoryErrAccept;
+
+	/** Trajectory selection thread planner and the manipulator which refers to it, planner state is not shared between threads */
+	typedef std::pair<golem::Planner::Ptr, grasp::Manipulator::Ptr> ManipulatorEntry;
+	/** Creates planners and manipulators of the trajectory selection threads */
+	std::function<ManipulatorEntry()> manipulatorCreate;
+	/** Planners and manipulators of the trajectory selection threads, which are not in use */
+	std::vector<ManipulatorEntry> manipulatorPool;
+	/** Manipulator pool lock */
+	golem::CriticalSection csManipulatorPool;
 
 	/* Withdraw action hand release fraction */
 	golem::Real withdrawReleaseFraction;
@@ -729,6 +1098,8 @@ protected:
 
 	/** Generate solutions */
 	void generateSolutions();
+	/** Path of the query density moved to the solution pose */
+	void createPath(const Data::Density& density, const grasp::RBCoord& pose, grasp::Manipulator::Waypoint::Seq& path) const;
 	/** Sort solutions */
 	void sortSolutions(Data::Solution::Seq& seq) const;
 
@@ -741,19 +1112,63 @@ protected:
 	/** Evaluation */
 	template <typename _Ptr> inline static golem::Real evaluateSample(_Ptr begin, _Ptr end, const grasp::RBCoord& coord) {
 		golem::Real likelihood = golem::numeric_const<golem::Real>::ZERO, c = golem::numeric_const<golem::Real>::ZERO;
-		for (_Ptr kernel = begin; kernel < end; ++kernel) {
-			const golem::Real dlin = kernel->p.distanceSqr(coord.p);
-			if (dlin < kernel->distMax.lin) {
-				const golem::Real dang = kernel->q.distance(coord.q);
-				if (dang < kernel->distMax.ang) {
-					const golem::Real distance = kernel->covInv.lin*dlin + kernel->covInv.ang*dang;
-					const golem::Real sampleLikelihood = kernel->weight*golem::Math::exp(-golem::Real(distance));
-					golem::kahanSum(likelihood, c, sampleLikelihood);
-				}
-			}
-		}
+		for (_Ptr kernel = begin; kernel < end; ++kernel)
+			KernelBatch::evaluate(*kernel, coord, likelihood, c);
+		return likelihood;
+	}
+	/** Evaluation visiting only kernels near the sample, the same kernels are summed in the same order as without the index */
+	inline static golem::Real evaluateSample(const grasp::Query::Pose::Seq& kernels, const KernelIndex& index, const grasp::RBCoord& coord, KernelIndex::IndexSeq& buffer) {
+		if (index.empty())
+			return evaluateSample(kernels.begin(), kernels.end(), coord);
+		golem::Real likelihood = golem::numeric_const<golem::Real>::ZERO, c = golem::numeric_const<golem::Real>::ZERO;
+		index.find(coord.p, buffer);
+		for (KernelIndex::IndexSeq::const_iterator i = buffer.begin(); i != buffer.end(); ++i)
+			KernelBatch::evaluate(kernels[*i], coord, likelihood, c);
 		return likelihood;
 	}
+	/** Evaluation visiting only kernels near the sample, several at a time if the processor supports it, otherwise as above */
+	inline static golem::Real evaluateSample(const grasp::Query::Pose::Seq& kernels, const KernelIndex& index, const KernelBatch& batch, const grasp::RBCoord& coord, KernelIndex::IndexSeq& indices, KernelIndex::RangeSeq& ranges) {
+		if (!batch.isVectorised())
+			return evaluateSample(kernels, index, coord, indices);
+		if (index.empty())
+			return batch.evaluate(kernels, coord);
+		golem::Real likelihood = golem::numeric_const<golem::Real>::ZERO, c = golem::numeric_const<golem::Real>::ZERO;
+		index.find(coord.p, ranges);
+		for (KernelIndex::RangeSeq::const_iterator i = ranges.begin(); i != ranges.end(); ++i)
+			batch.evaluate(kernels, coord, i->first, i->second, likelihood, c);
+		return likelihood;
+	}
+	/** Evaluation of several samples in one sweep: without the index over blocks of all kernels, with the index over the cells near any of the samples,
+	*	each cell loaded once for all the samples near it. The likelihood of every sample is the same as from evaluateSample().
+	*/
+	inline static void evaluateSamples(const grasp::Query::Pose::Seq& kernels, const KernelIndex& index, const KernelBatch& batch, const grasp::RBCoord* coords, size_t count, golem::Real* likelihoods, KernelIndex::IndexSeq& indices, KernelIndex::Sweep& sweep) {
+		if (index.empty()) {
+			batch.evaluate(kernels, coords, count, likelihoods);
+			return;
+		}
+		// the scalar path sums the kernels of all cells in index order, one sample at a time
+		if (!batch.isVectorised()) {
+			for (size_t i = 0; i < count; ++i)
+				likelihoods[i] = evaluateSample(kernels, index, coords[i], indices);
+			return;
+		}
+
+		// sum of each cell near each sample, cell by cell; a sum started from zero is the range sum itself
+		sweep.create(index, coords, coords + count);
+		for (std::vector<std::pair<golem::U32, golem::U32> >::const_iterator i = sweep.order.begin(); i != sweep.order.end(); ++i) {
+			const KernelIndex::RangeSeq::value_type& range = sweep.ranges[i->second];
+			golem::Real likelihood = golem::numeric_const<golem::Real>::ZERO, c = golem::numeric_const<golem::Real>::ZERO;
+			batch.evaluate(kernels, coords[sweep.positions[i->second]], range.first, range.second, likelihood, c);
+			sweep.sums[i->second] = likelihood;
+		}
+		// cell sums added in the order of evaluateSample()
+		for (size_t i = 0; i < count; ++i) {
+			golem::Real likelihood = golem::numeric_const<golem::Real>::ZERO, c = golem::numeric_const<golem::Real>::ZERO;
+			for (golem::U32 j = sweep.offsets[i]; j < sweep.offsets[i + 1]; ++j)
+				golem::kahanSum(likelihood, c, sweep.sums[j]);
+			likelihoods[i] = likelihood;
+		}
+	}
 
 	grasp::Camera* getWristCamera(const bool dontThrow = false) const;
 	golem::Mat34 getWristPose() const;
@@ -0,0 +1,299 @@
+/** @file KernelBatch.h
+*
+* Structure-of-arrays kernel density evaluation
+*
+*/
+
+#pragma once
+#ifndef _PACMAN_BHAM_DEMO_KERNELBATCH_H_ // if #pragma once is not supported
+#define _PACMAN_BHAM_DEMO_KERNELBATCH_H_
+
+#include <Grasp/Core/RBPose.h>
+#include <Grasp/Contact/Query.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PACMAN_KERNEL_BATCH_AVX2
+#define PACMAN_KERNEL_BATCH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define PACMAN_KERNEL_BATCH_AVX2
+#define PACMAN_KERNEL_BATCH_TARGET_AVX2
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+
+/** PaCMan name space */
+namespace pacman {
+
+//------------------------------------------------------------------------------
+
+/** Query density kernels as a structure of double arrays, evaluated several kernels at a time.
+*	The vectorised path is chosen at run time, the scalar path evaluates the original kernels exactly as before.
+*/
+class KernelBatch {
+public:
+	/** Evaluation path */
+	enum Path {
+		/** One kernel at a time */
+		PATH_SCALAR,
+		/** Four kernels at a time with AVX2 and FMA */
+		PATH_AVX2,
+	};
+	/** Kernels per vector */
+	static const size_t LANES = 4;
+	/** Kernels per block of a sweep over several samples, 256 kernels of 12 components stay in L1 */
+	static const size_t BLOCK = 256;
+	/** Samples per sweep */
+	static const size_t SAMPLES = 16;
+
+	/** Kernel indices */
+	typedef std::vector<golem::U32> IndexSeq;
+	/** Array of kernel components */
+	typedef std::vector<double> Array;
+
+	KernelBatch() : vectorised(false) {}
+
+	/** Best evaluation path supported by the processor */
+	static Path getPath() {
+		static const Path path = detectPath();
+		return path;
+	}
+
+	/** Copies kernels into arrays, in the given order of kernel indices or in the sequence order */
+	void create(const grasp::Query::Pose::Seq& seq, const IndexSeq* order = nullptr) {
+		const size_t size = order != nullptr ? order->size() : seq.size();
+		this->order.resize(size);
+		for (size_t i = 0; i < size; ++i)
+			this->order[i] = order != nullptr ? (*order)[i] : (golem::U32)i;
+
+		// a vector which starts at the last kernel can read LANES - 1 past the end, these kernels never pass the support test
+		const size_t padded = size + LANES - 1;
+		Array* arrays[] = {&px, &py, &pz, &qx, &qy, &qz, &qw, &covInvLin, &covInvAng, &weight};
+		for (size_t i = 0; i < sizeof(arrays)/sizeof(arrays[0]); ++i)
+			arrays[i]->assign(padded, 0.0);
+		distMaxLin.assign(padded, -1.0);
+		distMaxAng.assign(padded, -1.0);
+
+		for (size_t i = 0; i < size; ++i) {
+			const grasp::Query::Pose& kernel = seq[this->order[i]];
+			px[i] = (double)kernel.p.x; py[i] = (double)kernel.p.y; pz[i] = (double)kernel.p.z;
+			qx[i] = (double)kernel.q.x; qy[i] = (double)kernel.q.y; qz[i] = (double)kernel.q.z; qw[i] = (double)kernel.q.w;
+			covInvLin[i] = (double)kernel.covInv.lin; covInvAng[i] = (double)kernel.covInv.ang;
+			distMaxLin[i] = (double)kernel.distMax.lin; distMaxAng[i] = (double)kernel.distMax.ang;
+			weight[i] = (double)kernel.weight;
+		}
+
+		vectorised = getPath() != PATH_SCALAR && isAngularDistance(seq);
+	}
+
+	/** Number of kernels */
+	size_t size() const {
+		return order.size();
+	}
+	/** Kernels are evaluated several at a time */
+	bool isVectorised() const {
+		return vectorised;
+	}
+
+	/** Evaluation of a single kernel */
+	static void evaluate(const grasp::Query::Pose& kernel, const grasp::RBCoord& coord, golem::Real& likelihood, golem::Real& c) {
+		const golem::Real dlin = kernel.p.distanceSqr(coord.p);
+		if (dlin < kernel.distMax.lin) {
+			const golem::Real dang = kernel.q.distance(coord.q);
+			if (dang < kernel.distMax.ang) {
+				const golem::Real distance = kernel.covInv.lin*dlin + kernel.covInv.ang*dang;
+				const golem::Real sampleLikelihood = kernel.weight*golem::Math::exp(-golem::Real(distance));
+				golem::kahanSum(likelihood, c, sampleLikelihood);
+			}
+		}
+	}
+	/** Accumulates kernels [begin, end) in the array order, kernels are the sequence the arrays were created from */
+	void evaluate(const grasp::Query::Pose::Seq& kernels, const grasp::RBCoord& coord, size_t begin, size_t end, golem::Real& likelihood, golem::Real& c) const {
+#ifdef PACMAN_KERNEL_BATCH_AVX2
+		if (vectorised) {
+			golem::kahanSum(likelihood, c, golem::Real(evaluateAVX2(coord, begin, end)));
+			return;
+		}
+#endif
+		for (size_t i = begin; i < end; ++i)
+			evaluate(kernels[order[i]], coord, likelihood, c);
+	}
+	/** Evaluation of all kernels */
+	golem::Real evaluate(const grasp::Query::Pose::Seq& kernels, const grasp::RBCoord& coord) const {
+		golem::Real likelihood = golem::numeric_const<golem::Real>::ZERO, c = golem::numeric_const<golem::Real>::ZERO;
+		evaluate(kernels, coord, 0, size(), likelihood, c);
+		return likelihood;
+	}
+	/** Evaluation of all kernels for several samples, each block of kernels is evaluated for up to SAMPLES samples before the next one is loaded.
+	*	The likelihood of every sample is the same as from evaluate(kernels, coord).
+	*/
+	void evaluate(const grasp::Query::Pose::Seq& kernels, const grasp::RBCoord* coords, size_t count, golem::Real* likelihoods) const {
+		for (size_t i = 0; i < count; i += SAMPLES)
+			evaluateBlock(kernels, coords + i, std::min(count - i, size_t(SAMPLES)), likelihoods + i);
+	}
+
+private:
+	/** The vectorised path computes the angular distance as 1 - |q1.q2|, verified against golem::Quat::distance() on the kernels themselves */
+	static bool isAngularDistance(const grasp::Query::Pose::Seq& seq) {
+		if (seq.size() < 2)
+			return false;
+		for (size_t i = 0, n = std::min(seq.size(), size_t(16)); i < n; ++i) {
+			const golem::Quat &q1 = seq[i].q, &q2 = seq[(i*7 + 1)%seq.size()].q;
+			const double dot = (double)q1.x*q2.x + (double)q1.y*q2.y + (double)q1.z*q2.z + (double)q1.w*q2.w;
+			if (std::abs((double)q1.distance(q2) - (1.0 - std::abs(dot))) > 1e-6)
+				return false;
+		}
+		return true;
+	}
+
+	/** Sweep over all kernels for at most SAMPLES samples */
+	void evaluateBlock(const grasp::Query::Pose::Seq& kernels, const grasp::RBCoord* coords, size_t count, golem::Real* likelihoods) const {
+#ifdef PACMAN_KERNEL_BATCH_AVX2
+		if (vectorised) {
+			evaluateAVX2(coords, count, likelihoods);
+			return;
+		}
+#endif
+		golem::Real c[SAMPLES];
+		for (size_t j = 0; j < count; ++j)
+			likelihoods[j] = c[j] = golem::numeric_const<golem::Real>::ZERO;
+		for (size_t begin = 0; begin < size(); begin += BLOCK) {
+			const size_t end = std::min(begin + BLOCK, size());
+			for (size_t j = 0; j < count; ++j)
+				for (size_t i = begin; i < end; ++i)
+					evaluate(kernels[order[i]], coords[j], likelihoods[j], c[j]);
+		}
+	}
+
+	static Path detectPath() {
+#if defined(PACMAN_KERNEL_BATCH_AVX2) && defined(__GNUC__)
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? PATH_AVX2 : PATH_SCALAR;
+#elif defined(PACMAN_KERNEL_BATCH_AVX2) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return PATH_SCALAR;
+		__cpuid(info, 1);
+		// FMA and OS support for the AVX state
+		if ((info[2] & (1 << 12)) == 0 || (info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+			return PATH_SCALAR;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0 ? PATH_AVX2 : PATH_SCALAR;
+#else
+		return PATH_SCALAR;
+#endif
+	}
+
+#ifdef PACMAN_KERNEL_BATCH_AVX2
+	/** exp(x) for x <= 0, relative error below 1e-15, zero below -708 */
+	PACMAN_KERNEL_BATCH_TARGET_AVX2 static __m256d expAVX2(__m256d x) {
+		const __m256d underflow = _mm256_cmp_pd(x, _mm256_set1_pd(-708.0), _CMP_GE_OQ);
+		x = _mm256_max_pd(x, _mm256_set1_pd(-708.0));
+		// x = n*ln(2) + r, |r| <= ln(2)/2
+		const __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(6.93145751953125e-1), x);
+		r = _mm256_fnmadd_pd(n, _mm256_set1_pd(1.42860682030941723212e-6), r);
+		// Taylor series up to r^11
+		__m256d p = _mm256_set1_pd(1.0/39916800.0);
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0/3628800.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0/362880.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0/40320.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0/5040.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0/720.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0/120.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0/24.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0/6.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(0.5));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+		// 2^n from the exponent bits
+		const __m256i e = _mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n)), _mm256_set1_epi64x(1023)), 52);
+		return _mm256_and_pd(underflow, _mm256_mul_pd(p, _mm256_castsi256_pd(e)));
+	}
+
+	/** Masked evaluation of kernels [begin, end), Kahan summation in each lane continued from sums and comps.
+	*	begin must be a multiple of LANES for every range of a sample after the first, so each kernel stays in the same lane.
+	*/
+	PACMAN_KERNEL_BATCH_TARGET_AVX2 void accumulateAVX2(const grasp::RBCoord& coord, size_t begin, size_t end, double* sums, double* comps) const {
+		const __m256d cpx = _mm256_set1_pd((double)coord.p.x), cpy = _mm256_set1_pd((double)coord.p.y), cpz = _mm256_set1_pd((double)coord.p.z);
+		const __m256d cqx = _mm256_set1_pd((double)coord.q.x), cqy = _mm256_set1_pd((double)coord.q.y), cqz = _mm256_set1_pd((double)coord.q.z), cqw = _mm256_set1_pd((double)coord.q.w);
+		const __m256d one = _mm256_set1_pd(1.0), sign = _mm256_set1_pd(-0.0);
+		const __m256d lanes = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+
+		__m256d sum = _mm256_loadu_pd(sums), comp = _mm256_loadu_pd(comps);
+		for (size_t i = begin; i < end; i += LANES) {
+			const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(&px[i]), cpx);
+			const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&py[i]), cpy);
+			const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(&pz[i]), cpz);
+			const __m256d dlin = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+			__m256d mask = _mm256_cmp_pd(dlin, _mm256_loadu_pd(&distMaxLin[i]), _CMP_LT_OQ);
+			// kernels past the end of the range belong to the next one
+			if (i + LANES > end)
+				mask = _mm256_and_pd(mask, _mm256_cmp_pd(lanes, _mm256_set1_pd(double(end - i)), _CMP_LT_OQ));
+			if (_mm256_movemask_pd(mask) == 0)
+				continue;
+
+			const __m256d dot = _mm256_fmadd_pd(_mm256_loadu_pd(&qx[i]), cqx, _mm256_fmadd_pd(_mm256_loadu_pd(&qy[i]), cqy, _mm256_fmadd_pd(_mm256_loadu_pd(&qz[i]), cqz, _mm256_mul_pd(_mm256_loadu_pd(&qw[i]), cqw))));
+			const __m256d dang = _mm256_sub_pd(one, _mm256_andnot_pd(sign, dot));
+			mask = _mm256_and_pd(mask, _mm256_cmp_pd(dang, _mm256_loadu_pd(&distMaxAng[i]), _CMP_LT_OQ));
+			if (_mm256_movemask_pd(mask) == 0)
+				continue;
+
+			const __m256d distance = _mm256_fmadd_pd(_mm256_loadu_pd(&covInvLin[i]), dlin, _mm256_mul_pd(_mm256_loadu_pd(&covInvAng[i]), dang));
+			const __m256d value = _mm256_and_pd(mask, _mm256_mul_pd(_mm256_loadu_pd(&weight[i]), expAVX2(_mm256_xor_pd(distance, sign))));
+
+			const __m256d y = _mm256_sub_pd(value, comp);
+			const __m256d t = _mm256_add_pd(sum, y);
+			comp = _mm256_sub_pd(_mm256_sub_pd(t, sum), y);
+			sum = t;
+		}
+
+		_mm256_storeu_pd(sums, sum);
+		_mm256_storeu_pd(comps, comp);
+	}
+	/** Sum of the lanes */
+	static double reduce(const double* sums, const double* comps) {
+		double likelihood = 0.0, c = 0.0;
+		for (size_t j = 0; j < LANES; ++j) {
+			const double y = sums[j] - comps[j] - c;
+			const double t = likelihood + y;
+			c = (t - likelihood) - y;
+			likelihood = t;
+		}
+		return likelihood;
+	}
+	/** Masked evaluation of kernels [begin, end) */
+	double evaluateAVX2(const grasp::RBCoord& coord, size_t begin, size_t end) const {
+		double sums[LANES] = {0.0}, comps[LANES] = {0.0};
+		accumulateAVX2(coord, begin, end, sums, comps);
+		return reduce(sums, comps);
+	}
+	/** Masked evaluation of all kernels for at most SAMPLES samples, block by block */
+	void evaluateAVX2(const grasp::RBCoord* coords, size_t count, golem::Real* likelihoods) const {
+		double sums[SAMPLES*LANES] = {0.0}, comps[SAMPLES*LANES] = {0.0};
+		for (size_t begin = 0; begin < size(); begin += BLOCK) {
+			const size_t end = std::min(begin + BLOCK, size());
+			for (size_t j = 0; j < count; ++j)
+				accumulateAVX2(coords[j], begin, end, sums + j*LANES, comps + j*LANES);
+		}
+		for (size_t j = 0; j < count; ++j)
+			likelihoods[j] = golem::Real(reduce(sums + j*LANES, comps + j*LANES));
+	}
+#endif
+
+	IndexSeq order;
+	Array px, py, pz, qx, qy, qz, qw, covInvLin, covInvAng, distMaxLin, distMaxAng, weight;
+	bool vectorised;
+};
+
+//------------------------------------------------------------------------------
+
+};
+
+#endif // _PACMAN_BHAM_DEMO_KERNELBATCH_H_
@@ -0,0 +1,59 @@
+/** @file WorkCursor.h
+*
+* Lock-free distribution of loop indices between threads
+*
+*/
+
+#pragma once
+#ifndef _PACMAN_BHAM_DEMO_WORKCURSOR_H_ // if #pragma once is not supported
+#define _PACMAN_BHAM_DEMO_WORKCURSOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+//------------------------------------------------------------------------------
+
+/** PaCMan name space */
+namespace pacman {
+
+//------------------------------------------------------------------------------
+
+/** Indices [0, size) handed out in chunks to any number of threads, each thread takes the next chunk with a single atomic increment.
+*	Which thread gets which chunk depends on timing, so per index results must not depend on the thread.
+*/
+class WorkCursor {
+public:
+	WorkCursor(size_t size, size_t chunk = 1) : cursor(0), size(size), chunk(std::max(chunk, size_t(1))) {}
+
+	/** Next chunk [begin, end), false if all indices have been taken */
+	bool next(size_t& begin, size_t& end) {
+		begin = cursor.fetch_add(chunk, std::memory_order_relaxed);
+		if (begin >= size)
+			return false;
+		end = std::min(begin + chunk, size);
+		return true;
+	}
+
+	/** Number of indices */
+	size_t getSize() const {
+		return size;
+	}
+	/** Chunk size */
+	size_t getChunk() const {
+		return chunk;
+	}
+
+private:
+	std::atomic<size_t> cursor;
+	const size_t size, chunk;
+
+	WorkCursor(const WorkCursor&);
+	WorkCursor& operator = (const WorkCursor&);
+};
+
+//------------------------------------------------------------------------------
+
+};
+
+#endif // _PACMAN_BHAM_DEMO_WORKCURSOR_H_
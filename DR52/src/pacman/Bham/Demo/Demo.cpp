@@ -122,6 +122,64 @@ private:
 	ForceEvent();
 };
 
+/** FNV-1a fingerprint of raw bytes */
+const std::uint64_t HASH_SEED = 14695981039346656037ULL;
+inline std::uint64_t hashBytes(std::uint64_t hash, const void* data, size_t size) {
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+/** Fingerprints of the values a query density is created from, field by field so padding never takes part */
+inline std::uint64_t hashValue(std::uint64_t hash, std::uint64_t value) {
+	return hashBytes(hash, &value, sizeof(value));
+}
+inline std::uint64_t hashValue(std::uint64_t hash, golem::Real value) {
+	return hashBytes(hash, &value, sizeof(value));
+}
+inline std::uint64_t hashValue(std::uint64_t hash, const golem::Vec3& value) {
+	return hashValue(hashValue(hashValue(hash, value.x), value.y), value.z);
+}
+inline std::uint64_t hashValue(std::uint64_t hash, const golem::Quat& value) {
+	return hashValue(hashValue(hashValue(hashValue(hash, value.x), value.y), value.z), value.w);
+}
+inline std::uint64_t hashValue(std::uint64_t hash, const golem::Mat34& value) {
+	const golem::Real r[] = {
+		value.R.m11, value.R.m12, value.R.m13,
+		value.R.m21, value.R.m22, value.R.m23,
+		value.R.m31, value.R.m32, value.R.m33,
+	};
+	for (size_t i = 0; i < sizeof(r)/sizeof(r[0]); ++i)
+		hash = hashValue(hash, r[i]);
+	return hashValue(hash, value.p);
+}
+inline std::uint64_t hashValue(std::uint64_t hash, const grasp::Contact3D& value) {
+	return hashValue(hashValue(hashValue(hash, value.global.p), value.global.q), value.weight);
+}
+/** Time and joint positions of a controller state */
+inline std::uint64_t hashValue(std::uint64_t hash, const golem::Controller::State& value, const golem::Controller::State::Info& info) {
+	hash = hashValue(hash, golem::Real(value.t));
+	for (golem::Configspace::Index j = info.getJoints().begin(); j < info.getJoints().end(); ++j)
+		hash = hashValue(hash, value.cpos[j]);
+	return hash;
+}
+
+/** Rotation angle between two orientations */
+inline golem::Real angle(const golem::Quat& a, const golem::Quat& b) {
+	return golem::Real(2.0)*golem::Math::acos(std::min(golem::REAL_ONE, golem::Math::abs(a.dot(b))));
+}
+
+/** Reads an optional attribute, the value is unchanged if the attribute is missing */
+template <typename _Type> void XMLDataOptional(const char* attr, _Type& val, const golem::XMLContext* xmlcontext) {
+	try {
+		golem::XMLData(attr, val, const_cast<golem::XMLContext*>(xmlcontext));
+	}
+	catch (const golem::MsgXMLParser&) {
+	}
+}
+
 }
 
 //-----------------------------------------------------------------------------
@@ -383,10 +441,58 @@ bool Demo::Data::Cluster::isOccupied(const Map& map, const Counter& counter, con
 void Demo::Optimisation::load(const golem::XMLContext* xmlcontext) {
 	golem::XMLData("runs", runs, const_cast<golem::XMLContext*>(xmlcontext));
 	golem::XMLData("steps", steps, const_cast<golem::XMLContext*>(xmlcontext));
+	XMLDataOptional("chains", chains, xmlcontext);
 	golem::XMLData("sa_temp", saTemp, const_cast<golem::XMLContext*>(xmlcontext));
 	golem::XMLData("sa_delta_lin", saDelta.lin, const_cast<golem::XMLContext*>(xmlcontext));
 	golem::XMLData("sa_delta_ang", saDelta.ang, const_cast<golem::XMLContext*>(xmlcontext));
 	golem::XMLData("sa_energy", saEnergy, const_cast<golem::XMLContext*>(xmlcontext));
+
+	std::string schedule;
+	XMLDataOptional("schedule", schedule, xmlcontext);
+	if (schedule == "linear")
+		this->schedule = SCHEDULE_LINEAR;
+	else if (schedule == "exponential")
+		this->schedule = SCHEDULE_EXPONENTIAL;
+	else if (schedule == "adaptive")
+		this->schedule = SCHEDULE_ADAPTIVE;
+	else if (!schedule.empty())
+		throw Message(Message::LEVEL_ERROR, "Demo::Optimisation::load(): Unknown schedule %s", schedule.c_str());
+	XMLDataOptional("sa_accept_rate", saAcceptRate, xmlcontext);
+	XMLDataOptional("sa_patience", saPatience, xmlcontext);
+	XMLDataOptional("sa_tolerance", saTolerance, xmlcontext);
+
+	std::string search;
+	XMLDataOptional("search", search, xmlcontext);
+	if (search == "independent")
+		this->search = SEARCH_INDEPENDENT;
+	else if (search == "tempering")
+		this->search = SEARCH_TEMPERING;
+	else if (!search.empty())
+		throw Message(Message::LEVEL_ERROR, "Demo::Optimisation::load(): Unknown search %s", search.c_str());
+	XMLDataOptional("pt_ladder", ptLadder, xmlcontext);
+}
+
+void Demo::QueryCache::Desc::load(const golem::XMLContext* xmlcontext) {
+	XMLDataOptional("capacity", capacity, xmlcontext);
+	XMLDataOptional("frame_lin", frameTolerance.lin, xmlcontext);
+	XMLDataOptional("frame_ang", frameTolerance.ang, xmlcontext);
+}
+
+golem::Real Demo::Optimisation::getTemperature(size_t step) const {
+	const Real Scale = Real(steps - std::min(step, steps))/steps; // 0..1
+	if (schedule == SCHEDULE_EXPONENTIAL)
+		return std::pow(saTemp, REAL_ONE - Scale);
+	return (REAL_ONE - Scale)*saTemp + Scale;
+}
+
+void Demo::Optimisation::updateTemperature(golem::Real& temp, golem::Real& rate, bool accepted) const {
+	if (schedule != SCHEDULE_ADAPTIVE)
+		return;
+	// running acceptance rate over roughly the last 20 steps
+	rate += Real(0.05)*((accepted ? REAL_ONE : REAL_ZERO) - rate);
+	// geometric cooling to saTemp over all steps, faster if more proposals are accepted than the target and slower otherwise
+	const Real decay = std::pow(std::max(saTemp, numeric_const<Real>::EPS), REAL_ONE/steps);
+	temp = std::min(std::max(temp*decay*Math::exp(Real(0.1)*(saAcceptRate - rate)), saTemp), REAL_ONE);
 }
 
 //------------------------------------------------------------------------------
@@ -443,6 +549,11 @@ void Demo::Desc::load(golem::Context& context, const golem::XMLContext* xmlconte
 	poseMap.clear();
 	golem::XMLData(poseMap, poseMap.max_size(), xmlcontext->getContextFirst("query"), "query", false);
 
+	try {
+		queryCacheDesc.load(xmlcontext->getContextFirst("query cache"));
+	}
+	catch (const golem::MsgXMLParser&) {
+	}
 	optimisation.load(xmlcontext->getContextFirst("query optimisation"));
 
 	manipulatorDesc->load(xmlcontext->getContextFirst("manipulator"));
@@ -452,6 +563,11 @@ void Demo::Desc::load(golem::Context& context, const golem::XMLContext* xmlconte
 
 	golem::XMLData("duration", manipulatorTrajectoryDuration, xmlcontext->getContextFirst("manipulator trajectory"));
 	golem::XMLData(trajectoryThresholdForce, xmlcontext->getContextFirst("manipulator threshold"));
+	try {
+		grasp::XMLData(trajectoryErrAccept, xmlcontext->getContextFirst("manipulator trajectory_accept"), false);
+	}
+	catch (const golem::MsgXMLParser&) {
+	}
 
 	golem::XMLData("release_fraction", withdrawReleaseFraction, xmlcontext->getContextFirst("manipulator withdraw_action"));
 	golem::XMLData("lift_distance", withdrawLiftDistance, xmlcontext->getContextFirst("manipulator withdraw_action"));
@@ -908,11 +1024,23 @@ void pacman::Demo::create(const Desc& desc) {
 	for (Query::Desc::Map::const_iterator i = desc.queryDescMap.begin(); i != desc.queryDescMap.end(); ++i)
 		queryMap.insert(std::make_pair(i->first, i->second->create(context, i->first)));
 	poseMap = desc.poseMap;
+	queryCache.create(desc.queryCacheDesc);
 
 	optimisation = desc.optimisation;
 
 	// manipulator
 	manipulator = desc.manipulatorDesc->create(*planner, desc.controllerIDSeq);
+	{
+		// planners and their kinematics keep search state, so each trajectory selection thread gets its own planner
+		const golem::Planner::Desc::Ptr plannerDesc = desc.plannerDesc;
+		const grasp::Manipulator::Desc::Ptr manipulatorDesc = desc.manipulatorDesc;
+		const auto controllerIDSeq = desc.controllerIDSeq;
+		manipulatorCreate = [=] () -> ManipulatorEntry {
+			const golem::Planner::Ptr planner = plannerDesc->create(*this->controller);
+			return ManipulatorEntry(planner, manipulatorDesc->create(*planner, controllerIDSeq));
+		};
+	}
+	manipulatorPool.clear();
 	manipulatorAppearance = desc.manipulatorAppearance;
 	manipulatorItemTrj = desc.manipulatorItemTrj;
 
@@ -922,6 +1050,7 @@ void pacman::Demo::create(const Desc& desc) {
 
 	manipulatorTrajectoryDuration = desc.manipulatorTrajectoryDuration;
 	trajectoryThresholdForce = desc.trajectoryThresholdForce;
+	trajectoryErrAccept = desc.trajectoryErrAccept;
 
 	withdrawReleaseFraction = desc.withdrawReleaseFraction;
 	withdrawLiftDistance = desc.withdrawLiftDistance;
@@ -2153,6 +2282,12 @@ void pacman::Demo::createQuery(grasp::data::Item::Ptr item, const golem::Mat34&
 	if (poseAny == poseMap.end())
 		throw Message(Message::LEVEL_ERROR, "Demo::createQuery(): Unable to find pose density %s", ID_ANY.c_str());
 
+	// query features are the same for all slots
+	QueryCache::Key featuresKey = HASH_SEED;
+	if (queryCache.getDesc().capacity > 0)
+		for (size_t i = 0; i < features->getNumOfPoints(); ++i)
+			featuresKey = hashValue(featuresKey, features->getPoint(i));
+
 	to<Data>(dataCurrentPtr)->densities.clear();
 	for (Data::Training::Map::const_iterator i = to<Data>(dataCurrentPtr)->training.begin(); i != to<Data>(dataCurrentPtr)->training.end(); ++i) {
 		Data::Density density;
@@ -2181,31 +2316,6 @@ void pacman::Demo::createQuery(grasp::data::Item::Ptr item, const golem::Mat34&
 		grasp::Query::Map::const_iterator query = queryMap.find(i->first);
 		if (query == queryMap.end()) query = queryAny;
 
-		try {
-			query->second->clear();
-			//if (!golem::Sample<golem::Real>::normalise<golem::Ref1>(const_cast<grasp::Contact3D::Seq&>(i->second.contacts)))
-			//	throw Message(Message::LEVEL_ERROR, "Demo::createQuery(): Unable to normalise model distribution");
-			query->second->create(i->second.contacts, *features);
-		}
-		catch (const std::exception& ex) {
-			context.write("%s\n", ex.what());
-			continue;
-		}
-
-		// object density
-		density.object = query->second->getPoses();
-		for (grasp::Query::Pose::Seq::iterator j = density.object.begin(); j != density.object.end(); ++j) {
-			Mat34 trn;
-
-			// frame transform: eff_curr = frame, model = modelFrame
-			// model = trn * query |==> trn = model * query^-1
-			// eff_pred = trn * eff_curr |==> eff_pred = model * query^-1 * eff_curr
-			trn.setInverse(j->toMat34());
-			trn.multiply(trn, frame);
-			trn.multiply(to<Data>(dataCurrentPtr)->queryFrame, trn);
-			j->fromMat34(trn);
-		}
-
 		// select pose any
 		PoseDensity::Map::const_iterator pose = poseMap.find(i->first);
 		if (pose == poseMap.end()) pose = poseAny;
@@ -2225,81 +2335,146 @@ void pacman::Demo::createQuery(grasp::data::Item::Ptr item, const golem::Mat34&
 
 		// Desired trajectory frame at contact pose
 		const golem::Mat34 trajectoryFrame = forwardTransformArm(i->second.state);
-		// Contact and approach poses as recorded
-		const golem::Mat34 contactPose(forwardTransformArm(waypoints[0])), approachPose(forwardTransformArm(waypoints[1]));
-		// trajectoryFrame = trn * contactPose |==> trn = trajectoryFrame * contactPose^-1
-		golem::Mat34 trnTrj;
-		trnTrj.setInverse(contactPose);
-		trnTrj.multiply(trajectoryFrame, trnTrj);
-
-		// query = trn * model |==> trn = query * model^-1
-		golem::Mat34 trn;
-		trn.setInverse(to<Data>(dataCurrentPtr)->modelFrame);
-		trn.multiply(to<Data>(dataCurrentPtr)->queryFrame, trn);
-
-		// Contact and approach poses in the desired frame
-		const grasp::RBCoord contactFrame(trn * trajectoryFrame), approachFrame(trn * trnTrj * approachPose);
-
-		// distance
-		const RBDist frameDist(contactFrame.p.distance(approachFrame.p), contactFrame.q.distance(approachFrame.q));
-		if (frameDist.lin < REAL_EPS/* || frameDist.ang < REAL_EPS*/)
-			throw Message(Message::LEVEL_ERROR, "Demo::createQuery(): Invalid distance between waypoints");
-
-		// create pose distribution
-		const I32 range = pose->second.kernels / 2 + 1;
-		density.pose.reserve(2 * range + 1);
-		for (I32 j = -range; j <= range; ++j) {
-			const Real dist = Real(j)/range;
-
-			// kernel
-			grasp::Query::Pose qp;
-			
-			// interpolation factor
-			const grasp::RBDist interpol(dist * pose->second.pathDist.lin / frameDist.lin, REAL_ZERO/*dist * pose->second.pathDist.ang / frameDist.ang*/);
-
-			// linear interpolation/extrapolation
-			qp.p.interpolate(contactFrame.p, approachFrame.p, interpol.lin);
-			// angular interpolation/extrapolation, TODO use angular distance scaling
-			qp.q.slerp(contactFrame.q, approachFrame.q, interpol.lin);
-
-			// kernel parameters
-			qp.stdDev = pose->second.stdDev;
-			qp.cov.set(Math::sqr(qp.stdDev.lin), Math::sqr(qp.stdDev.ang));
-			qp.covInv.set(REAL_ONE / qp.cov.lin, REAL_ONE / qp.cov.ang);
-			qp.distMax.set(poseDistanceMax * qp.cov.lin, poseDistanceMax * qp.cov.ang);
-			// kernel weight
-			qp.weight = Math::exp( - Math::abs(dist)*pose->second.pathDistStdDev); // set this to 1.0 to ignore kernel weights
-
-			// add to pose distribution
-			density.pose.push_back(qp);
+
+		// cached density, if nothing it is created from has changed
+		QueryCache::Entry local, *entry = nullptr;
+		QueryCache::Key key = featuresKey;
+		if (queryCache.getDesc().capacity > 0) {
+			key = hashBytes(key, i->first.data(), i->first.size());
+			key = hashBytes(key, query->first.data(), query->first.size());
+			key = hashBytes(key, pose->first.data(), pose->first.size());
+			key = hashValue(key, (std::uint64_t)i->second.contacts.size());
+			for (grasp::Contact3D::Seq::const_iterator j = i->second.contacts.begin(); j != i->second.contacts.end(); ++j)
+				key = hashValue(key, *j);
+			key = hashValue(key, (std::uint64_t)waypoints.size());
+			for (golem::Controller::State::Seq::const_iterator j = waypoints.begin(); j != waypoints.end(); ++j)
+				key = hashValue(key, *j, info);
+			key = hashValue(key, trajectoryFrame);
+			key = hashValue(key, to<Data>(dataCurrentPtr)->modelFrame);
+			key = hashValue(key, to<Data>(dataCurrentPtr)->queryFrame);
+			entry = queryCache.find(key);
 		}
 
-		// normalise pose distribution
-		if (!golem::Sample<Real>::normalise<golem::Ref1>(density.pose))
-			throw Message(Message::LEVEL_ERROR, "Demo::createQuery(): Unable to normalise pose distribution");
+		if (entry == nullptr) {
+			Data::Density& base = local.base;
+			base.type = i->first;
 
-		// create path
-		density.path = manipulator->create(waypoints, [=](const Manipulator::Waypoint& l, const Manipulator::Waypoint& r) -> Real { return poseCovInv.dot(RBDist(l, r)); });
-		
-		// locations
-		Mat34 trnObj;
-		trnObj.setInverse(frame);
-		density.locations.clear();
-		density.locations.reserve(features->getNumOfPoints());
-		for (size_t i = 0; i < features->getNumOfPoints(); ++i) {
-			grasp::data::Point3D::Point p = features->getPoint(i);
-			trnObj.multiply(p, p);
-			density.locations.push_back(p);
+			try {
+				query->second->clear();
+				//if (!golem::Sample<golem::Real>::normalise<golem::Ref1>(const_cast<grasp::Contact3D::Seq&>(i->second.contacts)))
+				//	throw Message(Message::LEVEL_ERROR, "Demo::createQuery(): Unable to normalise model distribution");
+				query->second->create(i->second.contacts, *features);
+			}
+			catch (const std::exception& ex) {
+				context.write("%s\n", ex.what());
+				continue;
+			}
+
+			// object density, in the query features frame
+			base.object = query->second->getPoses();
+
+			// Contact and approach poses as recorded
+			const golem::Mat34 contactPose(forwardTransformArm(waypoints[0])), approachPose(forwardTransformArm(waypoints[1]));
+			// trajectoryFrame = trn * contactPose |==> trn = trajectoryFrame * contactPose^-1
+			golem::Mat34 trnTrj;
+			trnTrj.setInverse(contactPose);
+			trnTrj.multiply(trajectoryFrame, trnTrj);
+
+			// query = trn * model |==> trn = query * model^-1
+			golem::Mat34 trn;
+			trn.setInverse(to<Data>(dataCurrentPtr)->modelFrame);
+			trn.multiply(to<Data>(dataCurrentPtr)->queryFrame, trn);
+
+			// Contact and approach poses in the desired frame
+			const grasp::RBCoord contactFrame(trn * trajectoryFrame), approachFrame(trn * trnTrj * approachPose);
+
+			// distance
+			const RBDist frameDist(contactFrame.p.distance(approachFrame.p), contactFrame.q.distance(approachFrame.q));
+			if (frameDist.lin < REAL_EPS/* || frameDist.ang < REAL_EPS*/)
+				throw Message(Message::LEVEL_ERROR, "Demo::createQuery(): Invalid distance between waypoints");
+
+			// create pose distribution
+			const I32 range = pose->second.kernels / 2 + 1;
+			base.pose.reserve(2 * range + 1);
+			for (I32 j = -range; j <= range; ++j) {
+				const Real dist = Real(j)/range;
+
+				// kernel
+				grasp::Query::Pose qp;
+				
+				// interpolation factor
+				const grasp::RBDist interpol(dist * pose->second.pathDist.lin / frameDist.lin, REAL_ZERO/*dist * pose->second.pathDist.ang / frameDist.ang*/);
+
+				// linear interpolation/extrapolation
+				qp.p.interpolate(contactFrame.p, approachFrame.p, interpol.lin);
+				// angular interpolation/extrapolation, TODO use angular distance scaling
+				qp.q.slerp(contactFrame.q, approachFrame.q, interpol.lin);
+
+				// kernel parameters
+				qp.stdDev = pose->second.stdDev;
+				qp.cov.set(Math::sqr(qp.stdDev.lin), Math::sqr(qp.stdDev.ang));
+				qp.covInv.set(REAL_ONE / qp.cov.lin, REAL_ONE / qp.cov.ang);
+				qp.distMax.set(poseDistanceMax * qp.cov.lin, poseDistanceMax * qp.cov.ang);
+				// kernel weight
+				qp.weight = Math::exp( - Math::abs(dist)*pose->second.pathDistStdDev); // set this to 1.0 to ignore kernel weights
+
+				// add to pose distribution
+				base.pose.push_back(qp);
+			}
+
+			// normalise pose distribution
+			if (!golem::Sample<Real>::normalise<golem::Ref1>(base.pose))
+				throw Message(Message::LEVEL_ERROR, "Demo::createQuery(): Unable to normalise pose distribution");
+
+			// create path
+			base.path = manipulator->create(waypoints, [=](const Manipulator::Waypoint& l, const Manipulator::Waypoint& r) -> Real { return poseCovInv.dot(RBDist(l, r)); });
+
+			// end-effector frame
+			base.frame = trajectoryFrame;
+			
+			// likelihood
+			base.weight = query->second->weight;
+
+			entry = queryCache.getDesc().capacity > 0 ? &queryCache.insert(key, base) : &local;
 		}
+		else
+			context.debug("Demo::createQuery(): slot %s density is cached\n", i->first.c_str());
+
+		// object frame, a frame within tolerance of the cached one reuses its density
+		if (!entry->valid || entry->frame.p.distance(frame.p) > queryCache.getDesc().frameTolerance.lin || angle(RBCoord(entry->frame).q, RBCoord(frame).q) > queryCache.getDesc().frameTolerance.ang) {
+			Data::Density& density = entry->density;
+			density = entry->base;
+
+			// object density
+			for (grasp::Query::Pose::Seq::iterator j = density.object.begin(); j != density.object.end(); ++j) {
+				Mat34 trn;
+
+				// frame transform: eff_curr = frame, model = modelFrame
+				// model = trn * query |==> trn = model * query^-1
+				// eff_pred = trn * eff_curr |==> eff_pred = model * query^-1 * eff_curr
+				trn.setInverse(j->toMat34());
+				trn.multiply(trn, frame);
+				trn.multiply(to<Data>(dataCurrentPtr)->queryFrame, trn);
+				j->fromMat34(trn);
+			}
 
-		// end-effector frame
-		density.frame = trajectoryFrame;
-		
-		// likelihood
-		density.weight = query->second->weight;
+			// locations
+			Mat34 trnObj;
+			trnObj.setInverse(frame);
+			density.locations.clear();
+			density.locations.reserve(features->getNumOfPoints());
+			for (size_t i = 0; i < features->getNumOfPoints(); ++i) {
+				grasp::data::Point3D::Point p = features->getPoint(i);
+				trnObj.multiply(p, p);
+				density.locations.push_back(p);
+			}
+
+			entry->frame = frame;
+			entry->valid = true;
+		}
 
 		// done
-		to<Data>(dataCurrentPtr)->densities.push_back(density);
+		to<Data>(dataCurrentPtr)->densities.push_back(entry->density);
 	}
 
 	if (to<Data>(dataCurrentPtr)->densities.empty())
@@ -2316,173 +2491,337 @@ void pacman::Demo::generateSolutions() {
 
 	const SecTmReal t = context.getTimer().elapsed();
 
-	Mat34 referencePose;
-	
-	referencePose.setInverse(manipulator->getReferenceFrame());//manipulator->getBaseFrame());
+	size_t acceptGreedy = 0, acceptSA = 0, runsConverged = 0, stepsTotal = 0;
+	const U32 seed = context.getRandSeed()._U32[0];
 
-	size_t acceptGreedy = 0, acceptSA = 0;
+	// spatial indices of query densities
+	for (Data::Density::Seq::iterator i = to<Data>(dataCurrentPtr)->densities.begin(); i != to<Data>(dataCurrentPtr)->densities.end(); ++i) {
+		i->objectIndex.create(i->object);
+		i->poseIndex.create(i->pose);
+		i->objectBatch.create(i->object, i->objectIndex.empty() ? nullptr : &i->objectIndex.getIndices());
+		i->poseBatch.create(i->pose, i->poseIndex.empty() ? nullptr : &i->poseIndex.getIndices());
+	}
 
 	to<Data>(dataCurrentPtr)->solutions.resize(optimisation.runs);
-	Data::Solution::Seq::iterator ptr = to<Data>(dataCurrentPtr)->solutions.begin();
+	WorkCursor cursor(optimisation.runs, optimisation.chains);
 	CriticalSection cs;
 	ParallelsTask(context.getParallels(), [&](ParallelsTask*) {
-		const U32 jobId = context.getParallels()->getCurrentJob()->getJobId();
-		Rand rand(RandSeed(this->context.getRandSeed()._U32[0] + jobId, (U32)0));
-
-		Data::Solution *solution = nullptr, test;
+		// statistics of this thread, merged at the end
+		size_t greedy = 0, sa = 0, converged = 0, steps = 0;
+
+		// runs advanced step by step together, so that test solutions of the same query density are evaluated in one sweep over its kernels
+		struct Chain {
+			Data::Solution *solution, test;
+			// seeded by the run index, so that the run does not depend on the thread which takes it
+			Rand rand;
+			Data::Density::Seq::const_iterator query;
+			grasp::Query::Pose::Seq::const_iterator pose;
+			// steps done, step limit, steps without improvement, parallel tempering replica
+			size_t step, limit, stall, rung;
+			// temperature, running acceptance rate, likelihood of the last improvement
+			Real temp, rate, best;
+			bool active, pending, evaluated;
+		};
+		std::vector<Chain> chains(optimisation.chains);
+		std::vector<Chain*> ladder;
+		std::vector<size_t> members;
+		std::vector<grasp::RBCoord> coords;
+		std::vector<Real> likelihoods;
+		KernelIndex::IndexSeq kernels;
+		KernelIndex::Sweep sweep;
 
 		for (;;) {
-			// select next pointer
-			{
-				CriticalSectionWrapper csw(cs);
-				if (ptr == to<Data>(dataCurrentPtr)->solutions.end())
+			// select next runs
+			size_t begin, end;
+			if (!cursor.next(begin, end))
+				break;
+			const size_t size = end - begin;
+
+			for (size_t j = 0; j < size; ++j) {
+				Chain& chain = chains[j];
+				Rand& rand = chain.rand;
+				chain.solution = &to<Data>(dataCurrentPtr)->solutions[begin + j];
+				rand.setRandSeed(RandSeed(seed + (U32)(begin + j), (U32)0));
+				// sample query density, replicas share the query of the first one
+				for (;;) {
+					if (j > 0 && optimisation.search == Optimisation::SEARCH_TEMPERING) {
+						chain.query = chains[0].query;
+						break;
+					}
+					chain.query = golem::Sample<golem::Real>::sample<golem::Ref1, Data::Density::Seq::const_iterator>(to<Data>(dataCurrentPtr)->densities, rand);
+					if (chain.query == to<Data>(dataCurrentPtr)->densities.end()) {
+						context.error("Demo::generateSolutions(): Query density sampling error\n");
+						return;
+					}
 					break;
-				solution = &*ptr++;
-			}
-
-			// sample query density
-			Data::Density::Seq::const_iterator query;
-			for (;;) {
-				query = golem::Sample<golem::Real>::sample<golem::Ref1, Data::Density::Seq::const_iterator>(to<Data>(dataCurrentPtr)->densities, rand);
-				if (query == to<Data>(dataCurrentPtr)->densities.end()) {
-					context.error("Demo::generateSolutions(): Query density sampling error\n");
-					return;
 				}
-				break;
-			}
-			// sample pose density
-			grasp::Query::Pose::Seq::const_iterator pose;
-			for (;;) {
-				pose = golem::Sample<golem::Real>::sample<golem::Ref1, grasp::Query::Pose::Seq::const_iterator>(query->pose, rand);
-				if (pose == query->pose.end()) {
-					context.error("Demo::generateSolutions(): Pose density sampling error\n");
-					return;
+				// sample pose density
+				for (;;) {
+					chain.pose = golem::Sample<golem::Real>::sample<golem::Ref1, grasp::Query::Pose::Seq::const_iterator>(chain.query->pose, rand);
+					if (chain.pose == chain.query->pose.end()) {
+						context.error("Demo::generateSolutions(): Pose density sampling error\n");
+						return;
+					}
+					break;
 				}
-				break;
+				// set
+				chain.test.type = chain.query->type;
+				chain.test.queryIndex = (U32)(chain.query - to<Data>(dataCurrentPtr)->densities.begin());
 			}
-			// set
-			test.type = query->type;
-			test.queryIndex = (U32)(query - to<Data>(dataCurrentPtr)->densities.begin());
 
 			// local search: try to find better solution using simulated annealing
-			for (size_t s = 0; s <= optimisation.steps; ++s) {
-				const bool init = s == 0;
+			size_t spare = 0;
+			for (size_t j = 0; j < size; ++j) {
+				Chain& chain = chains[j];
+				chain.step = chain.stall = 0;
+				chain.limit = optimisation.steps;
+				chain.temp = REAL_ONE;
+				chain.rate = optimisation.saAcceptRate;
+				chain.rung = j;
+				chain.active = true;
+			}
+			for (size_t active = size, iteration = 0; active > 0; ++iteration) {
+				// schedule
+				for (size_t j = 0; j < size; ++j)
+					if (chains[j].active && optimisation.schedule != Optimisation::SCHEDULE_ADAPTIVE)
+						chains[j].temp = optimisation.getTemperature(chains[j].step);
+
+				// generate test solutions, until each active chain has a valid one
+				for (size_t j = 0; j < size; ++j)
+					chains[j].pending = chains[j].active;
+				for (size_t pending = active; pending > 0;) {
+					for (size_t j = 0; j < size; ++j) {
+						Chain& chain = chains[j];
+						Rand& rand = chain.rand;
+						chain.evaluated = !chain.pending;
+						if (!chain.pending)
+							continue;
+
+						const bool init = chain.step == 0;
+						const Real Temp = chain.temp*optimisation.getLadder(chain.rung);
+						const RBDist Delta(optimisation.saDelta.lin*Temp, optimisation.saDelta.ang*Temp);
+						Data::Solution& test = chain.test;
+						// Linear component
+						Vec3 v;
+						v.next(rand); // |v|==1
+						v.multiply(Math::abs(rand.nextGaussian<Real>(REAL_ZERO, Delta.lin*chain.pose->stdDev.lin)), v);
+						test.pose.p.add(init ? chain.pose->p : chain.solution->pose.p, v);
+						// Angular component
+						const Real poseCovInvAng = chain.pose->covInv.ang / Math::sqr(Delta.ang);
+						Quat q;
+						q.next(rand, poseCovInvAng);
+						test.pose.q.multiply(init ? chain.pose->q : chain.solution->pose.q, q);
+
+						test.likelihood.setToDefault();
+					}
 
-				// linear schedule
-				const Real Scale = Real(optimisation.steps - s)/optimisation.steps; // 0..1
-				const Real Temp = (REAL_ONE - Scale)*optimisation.saTemp + Scale;
-				const RBDist Delta(optimisation.saDelta.lin*Temp, optimisation.saDelta.ang*Temp);
-				const Real Energy = optimisation.saEnergy*Temp;
+					// evaluate, test solutions of the same query density together
+					for (size_t j = 0; j < size; ++j) {
+						if (chains[j].evaluated)
+							continue;
+						const Data::Density::Seq::const_iterator query = chains[j].query;
+						members.clear();
+						coords.clear();
+						for (size_t k = j; k < size; ++k)
+							if (!chains[k].evaluated && chains[k].query == query) {
+								chains[k].evaluated = true;
+								members.push_back(k);
+								coords.push_back(chains[k].test.pose);
+							}
+						// comment out to turn off expert
+						likelihoods.resize(coords.size());
+						evaluateSamples(query->object, query->objectIndex, query->objectBatch, coords.data(), coords.size(), likelihoods.data(), kernels, sweep);
+						for (size_t k = 0; k < members.size(); ++k)
+							chains[members[k]].test.likelihood.contact = likelihoods[k];
+						// pose density only where contact is valid
+						size_t valid = 0;
+						for (size_t k = 0; k < members.size(); ++k)
+							if (Data::Solution::Likelihood::isValid(chains[members[k]].test.likelihood.contact)) {
+								members[valid] = members[k];
+								coords[valid++] = chains[members[k]].test.pose;
+							}
+						members.resize(valid);
+						evaluateSamples(query->pose, query->poseIndex, query->poseBatch, coords.data(), valid, likelihoods.data(), kernels, sweep);
+						for (size_t k = 0; k < members.size(); ++k)
+							chains[members[k]].test.likelihood.pose = likelihoods[k];
+					}
 
-				// generate test solution
-				for (;;) {
-					// Linear component
-					Vec3 v;
-					v.next(rand); // |v|==1
-					v.multiply(Math::abs(rand.nextGaussian<Real>(REAL_ZERO, Delta.lin*pose->stdDev.lin)), v);
-					test.pose.p.add(init ? pose->p : solution->pose.p, v);
-					// Angular component
-					const Real poseCovInvAng = pose->covInv.ang / Math::sqr(Delta.ang);
-					Quat q;
-					q.next(rand, poseCovInvAng);
-					test.pose.q.multiply(init ? pose->q : solution->pose.q, q);
-
-					// create path
-					test.path = query->path;
-
-					// transform to the new frame
-					RBCoord inv;
-					inv.setInverse(test.path[0].frame);
-					for (Manipulator::Waypoint::Seq::iterator i = test.path.begin(); i != test.path.end(); ++i) {
-						
-						//i->multiply(inv, *i);
-						i->frame.multiply(inv, i->frame);
-						i->frame.multiply(test.pose * referencePose, i->frame);
+					for (size_t j = 0; j < size; ++j) {
+						Data::Solution& test = chains[j].test;
+						if (!chains[j].pending)
+							continue;
+						if (!Data::Solution::Likelihood::isValid(test.likelihood.contact))
+							continue;
+						if (!Data::Solution::Likelihood::isValid(test.likelihood.pose))
+							continue;
+						if (!Data::Solution::Likelihood::isValid(test.likelihood.collision = golem::numeric_const<golem::Real>::ONE))
+							continue;
+
+						test.likelihood.make();
+						//test.likelihood.makeLog();
+
+						chains[j].pending = false;
+						--pending;
 					}
+				}
 
-					// evaluate
-					test.likelihood.setToDefault();
-					// comment out to turn off expert
-					if (!Data::Solution::Likelihood::isValid(test.likelihood.contact = evaluateSample(query->object.begin(), query->object.end(), test.pose)))
+				for (size_t j = 0; j < size; ++j) {
+					Chain& chain = chains[j];
+					if (!chain.active)
 						continue;
-					if (!Data::Solution::Likelihood::isValid(test.likelihood.pose = evaluateSample(query->pose.begin(), query->pose.end(), test.pose)))
-						continue;
-					if (!Data::Solution::Likelihood::isValid(test.likelihood.collision = golem::numeric_const<golem::Real>::ONE))
+					Data::Solution *solution = chain.solution, &test = chain.test;
+					Rand& rand = chain.rand;
+					const Real Energy = optimisation.saEnergy*chain.temp*optimisation.getLadder(chain.rung);
+
+					// first run sampling only
+					if (chain.step++ == 0) {
+						*solution = test;
+						chain.best = solution->likelihood.likelihood;
 						continue;
+					}
 
-					test.likelihood.make();
-					//test.likelihood.makeLog();
+					// accept if better
+					const bool accepted = test.likelihood.likelihood > solution->likelihood.likelihood || Math::exp((test.likelihood.likelihood - solution->likelihood.likelihood) / Energy) > rand.nextUniform<Real>();
+					if (accepted) {
+						// debug
+						test.likelihood.likelihood > solution->likelihood.likelihood ? ++greedy : ++sa;
+						// update
+						solution->pose = test.pose;
+						solution->likelihood = test.likelihood;
+					}
+					optimisation.updateTemperature(chain.temp, chain.rate, accepted);
 
-					break;
+					// convergence
+					if (solution->likelihood.likelihood > chain.best + optimisation.saTolerance*Math::abs(chain.best)) {
+						chain.best = solution->likelihood.likelihood;
+						chain.stall = 0;
+					}
+					else if (optimisation.saPatience > 0 && ++chain.stall >= optimisation.saPatience) {
+						// remaining steps are given to runs which still improve
+						spare += chain.limit + 1 - chain.step;
+						chain.active = false;
+						--active;
+						++converged;
+					}
 				}
 
-				// first run sampling only
-				if (init) {
-					*solution = test;
-					continue;
+				// replica exchange between active runs at adjacent temperatures, even and odd pairs alternately
+				if (optimisation.search == Optimisation::SEARCH_TEMPERING && iteration > 0) {
+					ladder.clear();
+					for (size_t j = 0; j < size; ++j)
+						if (chains[j].active)
+							ladder.push_back(&chains[j]);
+					std::sort(ladder.begin(), ladder.end(), [] (const Chain* l, const Chain* r) -> bool { return l->rung < r->rung; });
+					for (size_t k = iteration%2; k + 1 < ladder.size(); k += 2) {
+						Chain &cold = *ladder[k], &hot = *ladder[k + 1];
+						const Real coldEnergy = optimisation.saEnergy*cold.temp*optimisation.getLadder(cold.rung);
+						const Real hotEnergy = optimisation.saEnergy*hot.temp*optimisation.getLadder(hot.rung);
+						// the hotter run always moves down if it is better, otherwise with the tempering exchange probability
+						if (Math::exp((hot.solution->likelihood.likelihood - cold.solution->likelihood.likelihood)*(REAL_ONE/coldEnergy - REAL_ONE/hotEnergy)) > cold.rand.nextUniform<Real>())
+							std::swap(cold.rung, hot.rung);
+					}
 				}
 
-				// accept if better
-				if (test.likelihood.likelihood > solution->likelihood.likelihood || Math::exp((test.likelihood.likelihood - solution->likelihood.likelihood) / Energy) > rand.nextUniform<Real>()) {
-					// debug
-					test.likelihood.likelihood > solution->likelihood.likelihood ? ++acceptGreedy : ++acceptSA;
-					// update
-					solution->pose = test.pose;
-					solution->path = test.path;
-					solution->likelihood = test.likelihood;
+				// runs at the end of their steps get spare steps best first, saPatience steps at a time
+				for (;;) {
+					Chain* last = nullptr;
+					for (size_t j = 0; j < size; ++j)
+						if (chains[j].active && chains[j].step > chains[j].limit && (last == nullptr || chains[j].solution->likelihood.likelihood > last->solution->likelihood.likelihood))
+							last = &chains[j];
+					if (last == nullptr)
+						break;
+					if (spare > 0) {
+						const size_t extension = std::min(spare, optimisation.saPatience);
+						last->limit += extension;
+						spare -= extension;
+					}
+					else {
+						last->active = false;
+						--active;
+					}
 				}
 			}
+
+			// paths of the final solutions only
+			for (size_t j = 0; j < size; ++j) {
+				createPath(*chains[j].query, chains[j].solution->pose, chains[j].solution->path);
+				steps += chains[j].step;
+			}
 		}
+
+		CriticalSectionWrapper csw(cs);
+		acceptGreedy += greedy;
+		acceptSA += sa;
+		runsConverged += converged;
+		stepsTotal += steps;
 	});
 
 	// sort
 	sortSolutions(to<Data>(dataCurrentPtr)->solutions);
 
 	// print debug information
-	context.debug("Demo::generateSolutions(): time=%.6f, solutions=%u, steps=%u, energy=%f, greedy_accept=%d, SA_accept=%d\n", context.getTimer().elapsed() - t, optimisation.runs, optimisation.steps, optimisation.saEnergy, acceptGreedy, acceptSA);
+	context.debug("Demo::generateSolutions(): time=%.6f, solutions=%u, steps=%u, energy=%f, greedy_accept=%d, SA_accept=%d, converged=%d, steps_total=%d\n", context.getTimer().elapsed() - t, optimisation.runs, optimisation.steps, optimisation.saEnergy, acceptGreedy, acceptSA, runsConverged, stepsTotal);
+}
+
+void pacman::Demo::createPath(const Data::Density& density, const grasp::RBCoord& pose, grasp::Manipulator::Waypoint::Seq& path) const {
+	Mat34 referencePose;
+	
+	referencePose.setInverse(manipulator->getReferenceFrame());//manipulator->getBaseFrame());
+
+	// create path
+	path = density.path;
+
+	// transform to the new frame
+	RBCoord inv;
+	inv.setInverse(path[0].frame);
+	for (Manipulator::Waypoint::Seq::iterator i = path.begin(); i != path.end(); ++i) {
+		
+		//i->multiply(inv, *i);
+		i->frame.multiply(inv, i->frame);
+		i->frame.multiply(pose * referencePose, i->frame);
+	}
 }
 
 void pacman::Demo::sortSolutions(Data::Solution::Seq& seq) const {
 	if (seq.empty())
 		throw Message(Message::LEVEL_ERROR, "Demo::sortSolutions(): No solutions");
 
-	// create pointers
-	typedef std::vector<const Data::Solution*> PtrSeq;
-	PtrSeq ptrSeq;
-	ptrSeq.reserve(seq.size());
-	for (Data::Solution::Seq::const_iterator i = seq.begin(); i != seq.end(); ++i)
-		ptrSeq.push_back(&*i);
-
-	// sort with clustering
-	std::sort(ptrSeq.begin(), ptrSeq.end(), [](const Data::Solution* l, const Data::Solution* r) -> bool {return l->queryIndex < r->queryIndex || l->queryIndex == r->queryIndex && l->likelihood.likelihood > r->likelihood.likelihood; });
-
-	// copy
-	//Data::Solution::Seq seqSorted;
-	//seqSorted.reserve(ptrSeq.size());
-	//for (PtrSeq::const_iterator i = ptrSeq.begin(); i != ptrSeq.end(); ++i)
-	//	seqSorted.push_back(**i);
-	Data::Solution::Seq seqSorted;
-	seqSorted.reserve(ptrSeq.size());
-	U32 clusterSize = manipulator->getDesc().trajectoryClusterSize, clusterId = ptrSeq.front()->queryIndex, clusterIndex = 0;
-	for (PtrSeq::const_iterator i = ptrSeq.begin(); i != ptrSeq.end();) {
-		seqSorted.push_back(**i++);
-		if (++clusterIndex >= clusterSize) {
-			for (; i != ptrSeq.end(); ++i)
-				if (clusterId != (*i)->queryIndex) {
-					clusterId = (*i)->queryIndex;
-					clusterIndex = 0;
-					break;
-				}
-		}
-		else if (clusterId != (*i)->queryIndex) {
-			clusterId = (*i)->queryIndex;
-			clusterIndex = 0;
-			break;
-		}
+	// cluster by query index
+	typedef std::vector<U32> IndexSeq;
+	IndexSeq clusters;
+	for (Data::Solution::Seq::const_iterator i = seq.begin(); i != seq.end(); ++i) {
+		if (clusters.size() <= i->queryIndex + 1)
+			clusters.resize(i->queryIndex + 2, 0);
+		++clusters[i->queryIndex + 1];
+	}
+	for (size_t i = 1; i < clusters.size(); ++i)
+		clusters[i] += clusters[i - 1];
+	IndexSeq indices(seq.size());
+	{
+		IndexSeq next(clusters.begin(), clusters.end() - 1);
+		for (U32 i = 0; i < (U32)seq.size(); ++i)
+			indices[next[seq[i].queryIndex]++] = i;
+	}
+
+	// the best trajectoryClusterSize solutions of each cluster, in descending order of likelihood
+	const size_t clusterSize = std::max((size_t)manipulator->getDesc().trajectoryClusterSize, size_t(1));
+	const auto greater = [&] (U32 l, U32 r) -> bool { return seq[l].likelihood.likelihood > seq[r].likelihood.likelihood; };
+	IndexSeq::iterator selected = indices.begin();
+	for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+		const IndexSeq::iterator begin = indices.begin() + clusters[c], end = indices.begin() + clusters[c + 1];
+		const IndexSeq::iterator top = begin + std::min(clusterSize, size_t(end - begin));
+		if (top < end)
+			std::nth_element(begin, top, end, greater);
+		std::sort(begin, top, greater);
+		selected = std::copy(begin, top, selected);
 	}
+	indices.erase(selected, indices.end());
 
-	// replace
-	seq = seqSorted;
+	// move
+	Data::Solution::Seq seqSorted(indices.size());
+	for (size_t i = 0; i < indices.size(); ++i)
+		seqSorted[i].swap(seq[indices[i]]);
+	seq.swap(seqSorted);
 }
 
 void pacman::Demo::selectTrajectory() {
@@ -2490,6 +2829,7 @@ void pacman::Demo::selectTrajectory() {
 		throw Message(Message::LEVEL_ERROR, "Demo::selectTrajectory(): No solutions");
 
 	const U32 testTrajectories = (U32)to<Data>(dataCurrentPtr)->solutions.size();
+	Data::Solution::Seq& solutions = to<Data>(dataCurrentPtr)->solutions;
 
 	// TODO collision detection
 	// collision bounds
@@ -2498,27 +2838,69 @@ void pacman::Demo::selectTrajectory() {
 	//}, &objectRenderer, &csRenderer);
 	//collisionBounds.setLocal();
 
-	// search
-	const std::pair<U32, RBDistEx> val = manipulator->find<U32>(0, testTrajectories, [&](U32 index) -> RBDistEx {
-		to<Data>(dataCurrentPtr)->indexSolution = index;
-		createRender();
-		Manipulator::Waypoint::Seq& path = to<Data>(dataCurrentPtr)->solutions[index].path;
-		const RBDist dist(manipulator->find(path));
-
-	//	manipulator->getConfig()
-
+	// candidates in descending order of likelihood
+	std::vector<U32> order(testTrajectories);
+	for (U32 i = 0; i < testTrajectories; ++i)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&] (U32 l, U32 r) -> bool { return solutions[l].likelihood.likelihood > solutions[r].likelihood.likelihood; });
+
+	// trajectory errors in candidate order, computed in parallel until a candidate within trajectoryErrAccept is found
+	const bool earlyAccept = trajectoryErrAccept.lin > REAL_ZERO && trajectoryErrAccept.ang > REAL_ZERO;
+	std::vector<RBDist> errors(testTrajectories);
+	std::vector<char> collisions(testTrajectories, 0), computed(testTrajectories, 0);
+	// the first accepted candidate, testTrajectories if none
+	std::atomic<size_t> accepted(testTrajectories);
+	WorkCursor cursor(testTrajectories);
+	ParallelsTask(context.getParallels(), [&](ParallelsTask*) {
+		// each thread has its own planner and manipulator
+		ManipulatorEntry entry;
+		{
+			CriticalSectionWrapper csw(csManipulatorPool);
+			if (manipulatorPool.empty())
+				manipulatorPool.push_back(manipulatorCreate());
+			entry = manipulatorPool.back();
+			manipulatorPool.pop_back();
+		}
+		grasp::Manipulator* manipulator = entry.second.get();
+
+		size_t begin, end;
+		while (cursor.next(begin, end) && begin < accepted.load()) {
+			Manipulator::Waypoint::Seq& path = solutions[order[begin]].path;
+			errors[begin] = RBDist(manipulator->find(path));
+			const bool collides = false;// collisionBounds.collides(manipulator->getConfig(path.back()), manipulator->getArm()->getStateInfo().getJoints().end() - 1); // TODO test approach config using locations
+			collisions[begin] = manipulator->getDesc().trajectoryErr.collision && collides;
+			computed[begin] = 1;
+
+			if (earlyAccept && !collisions[begin] && errors[begin].lin <= trajectoryErrAccept.lin && errors[begin].ang <= trajectoryErrAccept.ang) {
+				// less likely candidates are no longer needed, already running ones finish
+				size_t first = accepted.load();
+				while (begin < first && !accepted.compare_exchange_weak(first, begin));
+			}
+		}
 
-		const golem::ConfigspaceCoord approach = manipulator->getConfig(path.back());
-		const bool collides = false;// collisionBounds.collides(approach, manipulator->getArm()->getStateInfo().getJoints().end() - 1); // TODO test approach config using locations
-		const RBDistEx distex(dist, manipulator->getDesc().trajectoryErr.collision && collides);
-		context.write("#%03u/%u: Trajectory error: lin=%.9f, ang=%.9f, collision=%s\n", index + 1, testTrajectories, distex.lin, distex.ang, distex.collision ? "yes" : "no");
-		//if (getUICallback() && getUICallback()->hasInputEnabled()) Menu(context, *getUICallback()).option("\x0D", "Press <Enter> to continue...");
-		return distex;
+		CriticalSectionWrapper csw(csManipulatorPool);
+		manipulatorPool.push_back(entry);
 	});
 
-	context.write("#%03u: Best trajectory\n", val.first + 1);
-	to<Data>(dataCurrentPtr)->indexSolution = val.first;
-	const Data::Solution& solution = to<Data>(dataCurrentPtr)->solutions[val.first];
+	for (size_t i = 0; i < testTrajectories; ++i)
+		if (computed[i])
+			context.write("#%03u/%u: Trajectory error: lin=%.9f, ang=%.9f, collision=%s\n", order[i] + 1, testTrajectories, errors[i].lin, errors[i].ang, collisions[i] ? "yes" : "no");
+
+	// the accepted candidate or the best one
+	U32 index;
+	if (accepted.load() < testTrajectories) {
+		index = order[accepted.load()];
+		context.write("#%03u: Accepted trajectory\n", index + 1);
+	}
+	else {
+		const std::pair<U32, RBDistEx> val = manipulator->find<U32>(0, testTrajectories, [&](U32 i) -> RBDistEx {
+			return RBDistEx(errors[i], collisions[i] != 0);
+		});
+		index = order[val.first];
+		context.write("#%03u: Best trajectory\n", index + 1);
+	}
+	to<Data>(dataCurrentPtr)->indexSolution = index;
+	const Data::Solution& solution = solutions[index];
 	createRender();
 	Controller::State::Seq seq;
 	manipulator->copy(solution.path, seq);
@@ -12,6 +12,7 @@ SET(BASE_DEMO_DR55_NAME BaseDemoDR55)
 	)
 	SET(BASE_DEMO_DR55_HEADERS
 		${PROJECT_ROOT}/include/pacman/Bham/Demo/BaseDemo.h
+		${PROJECT_ROOT}/include/pacman/Bham/Demo/KernelBatch.h
 	)
 	
 	
@@ -24,6 +24,7 @@
 #include <Grasp/Contact/Model.h>
 #include <Grasp/Contact/Query.h>
 #include <Grasp/Contact/Manipulator.h>
+#include <pacman/Bham/Demo/KernelBatch.h>
 
 //------------------------------------------------------------------------------
 
@@ -100,6 +101,11 @@ public:
 			grasp::data::Point3D::Point::Seq points;
 			/** End-effector frame */
 			golem::Mat34 frame;
+
+			/** Object density kernel arrays, not serialised */
+			KernelBatch objectBatch;
+			/** Pose density kernel arrays, not serialised */
+			KernelBatch poseBatch;
 		};
 
 		/** Solution */
@@ -791,19 +797,14 @@ protected:
 	/** Evaluation */
 	template <typename _Ptr> inline static golem::Real evaluateSample(_Ptr begin, _Ptr end, const grasp::RBCoord& coord) {
 		golem::Real likelihood = golem::numeric_const<golem::Real>::ZERO, c = golem::numeric_const<golem::Real>::ZERO;
-		for (_Ptr kernel = begin; kernel < end; ++kernel) {
-			const golem::Real dlin = kernel->p.distanceSqr(coord.p);
-			if (dlin < kernel->distMax.lin) {
-				const golem::Real dang = kernel->q.distance(coord.q);
-				if (dang < kernel->distMax.ang) {
-					const golem::Real distance = kernel->covInv.lin*dlin + kernel->covInv.ang*dang;
-					const golem::Real sampleLikelihood = kernel->weight*golem::Math::exp(-golem::Real(distance));
-					golem::kahanSum(likelihood, c, sampleLikelihood);
-				}
-			}
-		}
+		for (_Ptr kernel = begin; kernel < end; ++kernel)
+			KernelBatch::evaluate(*kernel, coord, likelihood, c);
 		return likelihood;
 	}
+	/** Evaluation with the kernel arrays, several kernels at a time if the processor supports it, otherwise as above */
+	inline static golem::Real evaluateSample(const grasp::Query::Pose::Seq& kernels, const KernelBatch& batch, const grasp::RBCoord& coord) {
+		return batch.isVectorised() ? batch.evaluate(kernels, coord) : evaluateSample(kernels.begin(), kernels.end(), coord);
+	}
 
 	grasp::Camera* getWristCamera(const bool dontThrow = false, const std::string& sensorId = "OpenNI+OpenNI") const;
 	golem::Mat34 getWristPose(golem::U32 wristJoint = 33) const;
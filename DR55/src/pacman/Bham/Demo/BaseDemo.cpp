@@ -2670,6 +2670,12 @@ void pacman::BaseDemoDR55::generateSolutions() {
 
 	size_t acceptGreedy = 0, acceptSA = 0;
 
+	// kernel arrays of query densities
+	for (Data::Density::Seq::iterator i = to<Data>(dataCurrentPtr)->densities.begin(); i != to<Data>(dataCurrentPtr)->densities.end(); ++i) {
+		i->objectBatch.create(i->object);
+		i->poseBatch.create(i->pose);
+	}
+
 	to<Data>(dataCurrentPtr)->solutions.resize(optimisation.runs);
 	Data::Solution::Seq::iterator ptr = to<Data>(dataCurrentPtr)->solutions.begin();
 	CriticalSection cs;
@@ -2756,11 +2762,11 @@ void pacman::BaseDemoDR55::generateSolutions() {
 					test.likelihood.setToDefault();
 					// comment out to turn off expert
 					//printf("7\n");
-					if (!Data::Solution::Likelihood::isValid(test.likelihood.contact = evaluateSample(query->object.begin(), query->object.end(), test.pose)))
+					if (!Data::Solution::Likelihood::isValid(test.likelihood.contact = evaluateSample(query->object, query->objectBatch, test.pose)))
 						continue;
 					
 					//printf("8\n");
-					if (!Data::Solution::Likelihood::isValid(test.likelihood.pose = evaluateSample(query->pose.begin(), query->pose.end(), test.pose)))
+					if (!Data::Solution::Likelihood::isValid(test.likelihood.pose = evaluateSample(query->pose, query->poseBatch, test.pose)))
 						continue;
 
 					//printf("9\n");